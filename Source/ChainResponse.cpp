@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    ChainResponse.cpp
+
+  ==============================================================================
+*/
+
+#include "ChainResponse.h"
+
+void ChainResponseEvaluator::prepare(const double* frequencies, int newNumFrequencies, double sampleRate)
+{
+    jassert(newNumFrequencies >= 0);
+
+    if (sampleRate == preparedSampleRate
+        && newNumFrequencies == numFrequencies
+        && std::equal(frequencies, frequencies + newNumFrequencies, preparedFrequencies.begin()))
+        return;
+
+    preparedFrequencies.assign(frequencies, frequencies + newNumFrequencies);
+    preparedSampleRate = sampleRate;
+    numFrequencies = newNumFrequencies;
+
+    auto numRegisters = (static_cast<size_t>(numFrequencies) + Vec::size() - 1) / Vec::size();
+
+    cosW.assign(numRegisters, Vec::expand(0.0));
+    cos2W.assign(numRegisters, Vec::expand(0.0));
+    numeratorProducts.resize(numRegisters);
+    denominatorProducts.resize(numRegisters);
+
+    for (int i = 0; i < numFrequencies; ++i)
+    {
+        auto w = juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate;
+
+        cosW[i / Vec::size()].set(i % Vec::size(), std::cos(w));
+        cos2W[i / Vec::size()].set(i % Vec::size(), std::cos(2.0 * w));
+    }
+}
+
+void ChainResponseEvaluator::clearProducts()
+{
+    std::fill(numeratorProducts.begin(), numeratorProducts.end(), Vec::expand(1.0));
+    std::fill(denominatorProducts.begin(), denominatorProducts.end(), Vec::expand(1.0));
+}
+
+void ChainResponseEvaluator::accumulate(const BiquadCoefficients& c)
+{
+    // |b0 + b1 z^-1 + b2 z^-2|^2 on the unit circle, and the same for the poles with a0 == 1
+    auto n0 = Vec::expand(c.b0 * c.b0 + c.b1 * c.b1 + c.b2 * c.b2);
+    auto n1 = Vec::expand(2.0 * (c.b0 * c.b1 + c.b1 * c.b2));
+    auto n2 = Vec::expand(2.0 * c.b0 * c.b2);
+
+    auto d0 = Vec::expand(1.0 + c.a1 * c.a1 + c.a2 * c.a2);
+    auto d1 = Vec::expand(2.0 * (c.a1 + c.a1 * c.a2));
+    auto d2 = Vec::expand(2.0 * c.a2);
+
+    for (size_t v = 0; v < cosW.size(); ++v)
+    {
+        auto numerator = Vec::multiplyAdd(Vec::multiplyAdd(n0, n1, cosW[v]), n2, cos2W[v]);
+        auto denominator = Vec::multiplyAdd(Vec::multiplyAdd(d0, d1, cosW[v]), d2, cos2W[v]);
+
+        numeratorProducts[v] *= numerator;
+        denominatorProducts[v] *= denominator;
+    }
+}
+
+template<typename SampleType>
+void ChainResponseEvaluator::accumulate(const BasicFilter<SampleType>& filter)
+{
+    // Biquad IIR::Coefficients hold b0, b1, b2, a1, a2, already normalised
+    const auto& raw = filter.coefficients->coefficients;
+    jassert(raw.size() == 5);
+
+    BiquadCoefficients c;
+    c.b0 = raw[0];
+    c.b1 = raw[1];
+    c.b2 = raw[2];
+    c.a1 = raw[3];
+    c.a2 = raw[4];
+
+    accumulate(c);
+}
+
+void ChainResponseEvaluator::writeDecibels(float* outDb) const
+{
+    for (int i = 0; i < numFrequencies; ++i)
+    {
+        auto numerator = numeratorProducts[i / Vec::size()].get(i % Vec::size());
+        auto denominator = denominatorProducts[i / Vec::size()].get(i % Vec::size());
+
+        // Power ratio, floored at -100 dB like Decibels::gainToDecibels
+        auto power = juce::jmax(numerator / juce::jmax(denominator, 1.0e-30), 1.0e-10);
+        outDb[i] = static_cast<float>(10.0 * std::log10(power));
+    }
+}
+
+void ChainResponseEvaluator::computeResponse(const BiquadCoefficients* sections, int numSections, float* outDb)
+{
+    clearProducts();
+
+    for (int k = 0; k < numSections; ++k)
+        accumulate(sections[k]);
+
+    writeDecibels(outDb);
+}
+
+template<typename SampleType>
+void ChainResponseEvaluator::accumulateCut(const BasicCutFilter<SampleType>& cut)
+{
+    if (!cut.template isBypassed<0>())
+        accumulate(cut.template get<0>());
+    if (!cut.template isBypassed<1>())
+        accumulate(cut.template get<1>());
+    if (!cut.template isBypassed<2>())
+        accumulate(cut.template get<2>());
+    if (!cut.template isBypassed<3>())
+        accumulate(cut.template get<3>());
+}
+
+template<typename SampleType>
+void ChainResponseEvaluator::computeCutResponse(const BasicCutFilter<SampleType>& cut, float* outDb)
+{
+    clearProducts();
+    accumulateCut(cut);
+    writeDecibels(outDb);
+}
+
+template<typename SampleType>
+void ChainResponseEvaluator::computeBandResponse(const BasicFilter<SampleType>& band, float* outDb)
+{
+    clearProducts();
+    accumulate(band);
+    writeDecibels(outDb);
+}
+
+template<typename SampleType>
+void ChainResponseEvaluator::computeChainResponse(const BasicMonoChain<SampleType>& chain, float* outDb)
+{
+    clearProducts();
+
+    accumulateCut(chain.template get<ChainPositions::LowCut>());
+
+    const auto& bands = chain.template get<ChainPositions::Bands>();
+
+    for (size_t i = 0; i < bands.filters.size(); ++i)
+        if (!bands.bypassed[i])
+            accumulate(bands.filters[i]);
+
+    accumulateCut(chain.template get<ChainPositions::HighCut>());
+
+    writeDecibels(outDb);
+}
+
+template<typename SampleType>
+void computeChainResponse(const BasicMonoChain<SampleType>& chain, const double* frequencies, float* outDb,
+    int numFrequencies, double sampleRate)
+{
+    ChainResponseEvaluator evaluator;
+    evaluator.prepare(frequencies, numFrequencies, sampleRate);
+    evaluator.computeChainResponse(chain, outDb);
+}
+
+template void ChainResponseEvaluator::computeCutResponse<float>(const BasicCutFilter<float>&, float*);
+template void ChainResponseEvaluator::computeCutResponse<double>(const BasicCutFilter<double>&, float*);
+template void ChainResponseEvaluator::computeBandResponse<float>(const BasicFilter<float>&, float*);
+template void ChainResponseEvaluator::computeBandResponse<double>(const BasicFilter<double>&, float*);
+template void ChainResponseEvaluator::computeChainResponse<float>(const BasicMonoChain<float>&, float*);
+template void ChainResponseEvaluator::computeChainResponse<double>(const BasicMonoChain<double>&, float*);
+template void computeChainResponse<float>(const BasicMonoChain<float>&, const double*, float*, int, double);
+template void computeChainResponse<double>(const BasicMonoChain<double>&, const double*, float*, int, double);
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    ChainResponse.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MonoChain.h"
+#include "CoefficientEngine.h"
+
+#include <vector>
+
+/**
+    Evaluates the magnitude response of the filter chain at a fixed set of
+    frequencies, in one pass per section over all of them.
+
+    The cos(w) and cos(2w) tables are built once in prepare() and kept until the
+    frequencies or the sample rate change. With them, |H|^2 of a biquad is two
+    quadratics in cos(w), which are evaluated SIMD-wide. The numerator and
+    denominator products of all the sections are kept apart and only turned into
+    dB once at the end.
+*/
+class ChainResponseEvaluator
+{
+public:
+    // Rebuilds the tables if the frequencies or sample rate differ from last time
+    void prepare(const double* frequencies, int numFrequencies, double sampleRate);
+
+    int getNumFrequencies() const noexcept { return numFrequencies; }
+
+    // All of these write getNumFrequencies() values in dB
+    void computeResponse(const BiquadCoefficients* sections, int numSections, float* outDb);
+
+    // For float and double chains
+    template<typename SampleType>
+    void computeCutResponse(const BasicCutFilter<SampleType>& cut, float* outDb);
+
+    template<typename SampleType>
+    void computeBandResponse(const BasicFilter<SampleType>& band, float* outDb);
+
+    template<typename SampleType>
+    void computeChainResponse(const BasicMonoChain<SampleType>& chain, float* outDb);
+
+private:
+    using Vec = juce::dsp::SIMDRegister<double>;
+
+    void clearProducts();
+    void accumulate(const BiquadCoefficients& section);
+
+    template<typename SampleType>
+    void accumulate(const BasicFilter<SampleType>& filter);
+
+    template<typename SampleType>
+    void accumulateCut(const BasicCutFilter<SampleType>& cut);
+
+    void writeDecibels(float* outDb) const;
+
+    std::vector<double> preparedFrequencies;
+    double preparedSampleRate{ 0.0 };
+    int numFrequencies{ 0 };
+
+    // Padded to a whole number of registers
+    std::vector<Vec> cosW, cos2W;
+    std::vector<Vec> numeratorProducts, denominatorProducts;
+};
+
+// One-off evaluation, for callers that don't keep an evaluator around
+template<typename SampleType>
+void computeChainResponse(const BasicMonoChain<SampleType>& chain, const double* frequencies, float* outDb,
+    int numFrequencies, double sampleRate);
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ChainSettings.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+
+enum Slope
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48,
+};
+
+// The parametric bands between the low and high cut. Band 1 is the original
+// "Peak" band, in the same order as the choices of each band's "Type" parameter.
+constexpr int numParametricBands = 8;
+
+// Where each band starts out: band 1 at the peak's old default, the others
+// spread over the spectrum
+constexpr float defaultBandFrequencies[numParametricBands] = { 750.f, 60.f, 150.f, 400.f, 1500.f, 3500.f, 7000.f, 12000.f };
+
+enum BandType
+{
+    Band_Off,
+    Band_Peak,
+    Band_LowShelf,
+    Band_HighShelf,
+    Band_Notch
+};
+
+struct BandSettings
+{
+    BandType type{ BandType::Band_Off };
+    float freq{ 0 }, gainInDecibels{ 0 }, quality{ 1.f };
+};
+
+struct ChainSettings
+{
+    float lowCutFreq{ 0 }, highCutFreq{ 0 };
+    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
+
+    std::array<BandSettings, numParametricBands> bands;
+};
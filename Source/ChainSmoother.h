@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    ChainSmoother.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+
+#include <utility>
+
+/**
+    Ramps the continuous ChainSettings towards their targets, so automation can be
+    followed on a sub-block grid instead of jumping once per host block.
+    Frequencies and Q ramp multiplicatively, the gain in dB ramps linearly.
+    Slopes and band types are not continuous and always follow the target
+    straight away.
+*/
+struct ChainSmoother
+{
+    void reset(double sampleRate, double rampLengthSeconds)
+    {
+        rampLengthInSamples = juce::roundToInt(sampleRate * rampLengthSeconds);
+        samplesUntilSettled = 0;
+
+        lowCutFreq.reset(sampleRate, rampLengthSeconds);
+        highCutFreq.reset(sampleRate, rampLengthSeconds);
+
+        for (auto& band : bands)
+        {
+            band.freq.reset(sampleRate, rampLengthSeconds);
+            band.gain.reset(sampleRate, rampLengthSeconds);
+            band.quality.reset(sampleRate, rampLengthSeconds);
+        }
+    }
+
+    void setCurrentAndTargetValues(const ChainSettings& chainSettings)
+    {
+        lowCutFreq.setCurrentAndTargetValue(chainSettings.lowCutFreq);
+        highCutFreq.setCurrentAndTargetValue(chainSettings.highCutFreq);
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            const auto& settings = chainSettings.bands[i];
+
+            bands[i].freq.setCurrentAndTargetValue(settings.freq);
+            bands[i].gain.setCurrentAndTargetValue(settings.gainInDecibels);
+            bands[i].quality.setCurrentAndTargetValue(settings.quality);
+        }
+
+        setDiscreteValues(chainSettings);
+
+        targets = chainSettings;
+        samplesUntilSettled = 0;
+    }
+
+    void setTargetValues(const ChainSettings& chainSettings)
+    {
+        // Any moved target restarts its ramp, and all ramps are the same length
+        if (getChangedBands(targets, chainSettings) != 0)
+            samplesUntilSettled = rampLengthInSamples;
+
+        targets = chainSettings;
+
+        lowCutFreq.setTargetValue(chainSettings.lowCutFreq);
+        highCutFreq.setTargetValue(chainSettings.highCutFreq);
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            const auto& settings = chainSettings.bands[i];
+
+            bands[i].freq.setTargetValue(settings.freq);
+            bands[i].gain.setTargetValue(settings.gainInDecibels);
+            bands[i].quality.setTargetValue(settings.quality);
+        }
+
+        setDiscreteValues(chainSettings);
+    }
+
+    // The bands that are still ramping, as CoefficientEngine::Band flags
+    int getSmoothingBands() const
+    {
+        int flags = 0;
+
+        if (lowCutFreq.isSmoothing())
+            flags |= CoefficientEngine::LowCutBand;
+
+        if (highCutFreq.isSmoothing())
+            flags |= CoefficientEngine::HighCutBand;
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            const auto& band = bands[i];
+
+            // An "Off" band has nothing to redesign, however its knobs move
+            if (band.type != Band_Off
+                && (band.freq.isSmoothing() || band.gain.isSmoothing() || band.quality.isSmoothing()))
+                flags |= CoefficientEngine::getParametricBand(static_cast<int>(i));
+        }
+
+        return flags;
+    }
+
+    bool isSmoothing() const { return getSmoothingBands() != 0; }
+
+    // The bands whose slope or type changed since the last call, as
+    // CoefficientEngine::Band flags. They need a new design whether they are
+    // ramping or not.
+    int takeDiscreteChanges() { return std::exchange(discreteChanges, 0); }
+
+    // How far the last ramp to start is from its end, i.e. where the targets
+    // are reached exactly
+    int getSamplesUntilSettled() const noexcept { return samplesUntilSettled; }
+
+    // Advances every ramp and returns the settings reached at the end of numSamples
+    ChainSettings skip(int numSamples)
+    {
+        samplesUntilSettled = juce::jmax(0, samplesUntilSettled - numSamples);
+
+        ChainSettings settings;
+
+        settings.lowCutFreq = lowCutFreq.skip(numSamples);
+        settings.highCutFreq = highCutFreq.skip(numSamples);
+
+        settings.lowCutSlope = lowCutSlope;
+        settings.highCutSlope = highCutSlope;
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            auto& band = settings.bands[i];
+
+            band.type = bands[i].type;
+            band.freq = bands[i].freq.skip(numSamples);
+            band.gainInDecibels = bands[i].gain.skip(numSamples);
+            band.quality = bands[i].quality.skip(numSamples);
+        }
+
+        return settings;
+    }
+
+private:
+    using MultiplicativeValue = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    void setDiscreteValues(const ChainSettings& chainSettings)
+    {
+        if (lowCutSlope != chainSettings.lowCutSlope)
+            discreteChanges |= CoefficientEngine::LowCutBand;
+
+        if (highCutSlope != chainSettings.highCutSlope)
+            discreteChanges |= CoefficientEngine::HighCutBand;
+
+        lowCutSlope = chainSettings.lowCutSlope;
+        highCutSlope = chainSettings.highCutSlope;
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            if (bands[i].type != chainSettings.bands[i].type)
+                discreteChanges |= CoefficientEngine::getParametricBand(static_cast<int>(i));
+
+            bands[i].type = chainSettings.bands[i].type;
+        }
+    }
+
+    MultiplicativeValue lowCutFreq, highCutFreq;
+    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
+
+    struct BandSmoother
+    {
+        MultiplicativeValue freq, quality;
+        juce::SmoothedValue<float> gain;
+        BandType type{ BandType::Band_Off };
+    };
+
+    std::array<BandSmoother, numParametricBands> bands;
+
+    ChainSettings targets;
+    int rampLengthInSamples{ 0 }, samplesUntilSettled{ 0 };
+    int discreteChanges{ 0 };
+};
@@ -0,0 +1,248 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientCache.h"
+
+#include <cstring>
+
+template<typename To, typename From>
+static To bitCast(From from)
+{
+    static_assert(sizeof(To) == sizeof(From), "bitCast needs types of the same size");
+
+    To to;
+    std::memcpy(&to, &from, sizeof(To));
+    return to;
+}
+
+CoefficientCache::Key CoefficientCache::makeKey(Design design, int variant, float frequency, float quality,
+    float gainInDecibels, double sampleRate)
+{
+    // Only the settings a design depends on are set, the rest stay 0 so that
+    // e.g. the gain of a notch doesn't make it look like a new design
+    auto word0 = static_cast<juce::uint64>(design)
+        | (static_cast<juce::uint64>(variant & 0xff) << 8)
+        | (static_cast<juce::uint64>(bitCast<juce::uint32>(gainInDecibels)) << 32);
+
+    auto word1 = static_cast<juce::uint64>(bitCast<juce::uint32>(frequency))
+        | (static_cast<juce::uint64>(bitCast<juce::uint32>(quality)) << 32);
+
+    return { word0, word1, bitCast<juce::uint64>(sampleRate) };
+}
+
+size_t CoefficientCache::getHash(const Key& key)
+{
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+
+    for (auto word : key)
+    {
+        hash ^= word;
+        hash *= 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+bool CoefficientCache::find(const Key& key, Value& value, int numValues) const
+{
+    auto hash = getHash(key);
+
+    for (int probe = 0; probe < maxProbes; ++probe)
+    {
+        const auto& slot = slots[(hash + static_cast<size_t>(probe)) % numSlots];
+        auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+        if (sequence == 0 || (sequence & 1) != 0)
+            continue;
+
+        bool matches = true;
+
+        for (int i = 0; i < keyWords && matches; ++i)
+            matches = slot.words[static_cast<size_t>(i)].load(std::memory_order_relaxed) == key[static_cast<size_t>(i)];
+
+        if (!matches)
+            continue;
+
+        for (int i = 0; i < numValues; ++i)
+            value[static_cast<size_t>(i)] = bitCast<double>(slot.words[static_cast<size_t>(keyWords + i)].load(std::memory_order_relaxed));
+
+        // A writer got in while we were copying: treat it as a miss
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+            return true;
+    }
+
+    return false;
+}
+
+void CoefficientCache::insert(const Key& key, const Value& value, int numValues)
+{
+    const juce::ScopedLock sl(insertLock);
+
+    auto hash = getHash(key);
+    Slot* target = nullptr;
+    Slot* empty = nullptr;
+
+    // Overwrite the slot already holding this key, so a design stored twice
+    // doesn't take a second slot. Otherwise use the first empty one.
+    for (int probe = 0; probe < maxProbes && target == nullptr; ++probe)
+    {
+        auto& slot = slots[(hash + static_cast<size_t>(probe)) % numSlots];
+
+        if (slot.sequence.load(std::memory_order_relaxed) == 0)
+        {
+            if (empty == nullptr)
+                empty = &slot;
+
+            continue;
+        }
+
+        // Only writers change the words, and they all hold the lock
+        bool matches = true;
+
+        for (int i = 0; i < keyWords && matches; ++i)
+            matches = slot.words[static_cast<size_t>(i)].load(std::memory_order_relaxed) == key[static_cast<size_t>(i)];
+
+        if (matches)
+            target = &slot;
+    }
+
+    if (target == nullptr)
+        target = empty;
+
+    // Otherwise evict one of them, round robin
+    if (target == nullptr)
+    {
+        target = &slots[(hash + nextVictim) % numSlots];
+        nextVictim = (nextVictim + 1) % maxProbes;
+    }
+
+    auto sequence = target->sequence.load(std::memory_order_relaxed);
+
+    target->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int i = 0; i < keyWords; ++i)
+        target->words[static_cast<size_t>(i)].store(key[static_cast<size_t>(i)], std::memory_order_relaxed);
+
+    for (int i = 0; i < numValues; ++i)
+        target->words[static_cast<size_t>(keyWords + i)].store(bitCast<juce::uint64>(value[static_cast<size_t>(i)]), std::memory_order_relaxed);
+
+    target->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//==============================================================================
+static void toValue(const BiquadCoefficients& c, double* value)
+{
+    value[0] = c.b0;
+    value[1] = c.b1;
+    value[2] = c.b2;
+    value[3] = c.a1;
+    value[4] = c.a2;
+}
+
+static void fromValue(BiquadCoefficients& c, const double* value)
+{
+    c.b0 = value[0];
+    c.b1 = value[1];
+    c.b2 = value[2];
+    c.a1 = value[3];
+    c.a2 = value[4];
+}
+
+void CoefficientCache::designBandFilter(BandCoefficients& coefficients, const BandSettings& bandSettings,
+    double sampleRate, Access access)
+{
+    coefficients.bypassed = isBandFlat(bandSettings);
+
+    if (bandSettings.type == Band_Off)
+    {
+        coefficients.section = {};
+        return;
+    }
+
+    auto gainInDecibels = bandSettings.type == Band_Notch ? 0.f : bandSettings.gainInDecibels;
+    auto key = makeKey(BandDesign, bandSettings.type, bandSettings.freq, bandSettings.quality,
+        gainInDecibels, sampleRate);
+
+    Value value;
+
+    if (find(key, value, 5))
+    {
+        fromValue(coefficients.section, value.data());
+        return;
+    }
+
+    ::designBandFilter(coefficients.section, bandSettings, sampleRate);
+
+    if (access == FindOrInsert)
+    {
+        toValue(coefficients.section, value.data());
+        insert(key, value, 5);
+    }
+}
+
+void CoefficientCache::designLowCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings,
+    double sampleRate, Access access)
+{
+    auto numValues = 5 * (chainSettings.lowCutSlope + 1);
+    auto key = makeKey(LowCutDesign, chainSettings.lowCutSlope, chainSettings.lowCutFreq, 0.f, 0.f, sampleRate);
+
+    Value value;
+
+    if (find(key, value, numValues))
+    {
+        for (int i = 0; i <= chainSettings.lowCutSlope; ++i)
+            fromValue(coefficients.sections[static_cast<size_t>(i)], value.data() + 5 * i);
+
+        coefficients.slope = chainSettings.lowCutSlope;
+        coefficients.bypassed = isLowCutOpen(chainSettings);
+        return;
+    }
+
+    ::designLowCutFilter(coefficients, chainSettings, sampleRate);
+
+    if (access == FindOrInsert)
+    {
+        for (int i = 0; i <= chainSettings.lowCutSlope; ++i)
+            toValue(coefficients.sections[static_cast<size_t>(i)], value.data() + 5 * i);
+
+        insert(key, value, numValues);
+    }
+}
+
+void CoefficientCache::designHighCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings,
+    double sampleRate, Access access)
+{
+    auto numValues = 5 * (chainSettings.highCutSlope + 1);
+    auto key = makeKey(HighCutDesign, chainSettings.highCutSlope, chainSettings.highCutFreq, 0.f, 0.f, sampleRate);
+
+    Value value;
+
+    if (find(key, value, numValues))
+    {
+        for (int i = 0; i <= chainSettings.highCutSlope; ++i)
+            fromValue(coefficients.sections[static_cast<size_t>(i)], value.data() + 5 * i);
+
+        coefficients.slope = chainSettings.highCutSlope;
+        coefficients.bypassed = isHighCutOpen(chainSettings);
+        return;
+    }
+
+    ::designHighCutFilter(coefficients, chainSettings, sampleRate);
+
+    if (access == FindOrInsert)
+    {
+        for (int i = 0; i <= chainSettings.highCutSlope; ++i)
+            toValue(coefficients.sections[static_cast<size_t>(i)], value.data() + 5 * i);
+
+        insert(key, value, numValues);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+
+#include <array>
+#include <atomic>
+
+/**
+    Designed coefficient sets, shared by every plugin instance in the process.
+    Hold it with a juce::SharedResourcePointer<CoefficientCache>.
+
+    Each slot is guarded by a sequence number (odd while it is being written)
+    and holds its key and coefficients as atomic words, so finding a design is
+    a handful of atomic loads: it never locks, allocates or waits, and is safe
+    on the audio thread. Inserting takes a lock and may evict an older design,
+    so only threads that are allowed to block insert.
+
+    The design* functions give the same results as the free functions of the
+    same name, looking the design up first.
+*/
+class CoefficientCache
+{
+public:
+    enum Access
+    {
+        FindOnly,       // The audio thread: a miss is designed but not stored
+        FindOrInsert    // Everything else
+    };
+
+    // Also sets the band's bypassed flag, like the engine does
+    void designBandFilter(BandCoefficients& coefficients, const BandSettings& bandSettings,
+        double sampleRate, Access access);
+    void designLowCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings,
+        double sampleRate, Access access);
+    void designHighCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings,
+        double sampleRate, Access access);
+
+private:
+    static constexpr int numSlots = 1024;
+    static constexpr int maxProbes = 4;
+
+    static constexpr int keyWords = 3;
+    static constexpr int valueWords = 4 * 5;
+
+    enum Design
+    {
+        BandDesign,
+        LowCutDesign,
+        HighCutDesign
+    };
+
+    using Key = std::array<juce::uint64, keyWords>;
+    using Value = std::array<double, valueWords>;
+
+    struct Slot
+    {
+        // 0 while empty, odd while being written
+        std::atomic<juce::uint32> sequence{ 0 };
+        std::array<std::atomic<juce::uint64>, keyWords + valueWords> words{};
+    };
+
+    // variant is the slope of a cut, or the type of a band
+    static Key makeKey(Design design, int variant, float frequency, float quality, float gainInDecibels, double sampleRate);
+    static size_t getHash(const Key& key);
+
+    bool find(const Key& key, Value& value, int numValues) const;
+    void insert(const Key& key, const Value& value, int numValues);
+
+    std::array<Slot, numSlots> slots;
+
+    // Only writers take it
+    juce::CriticalSection insertLock;
+    size_t nextVictim{ 0 };
+};
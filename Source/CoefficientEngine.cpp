@@ -0,0 +1,424 @@
+/*
+  ==============================================================================
+
+    CoefficientEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientEngine.h"
+#include "CoefficientCache.h"
+
+static void setNormalised(BiquadCoefficients& c,
+    double b0, double b1, double b2,
+    double a0, double a1, double a2)
+{
+    jassert(a0 != 0.0);
+    auto a0Inv = 1.0 / a0;
+
+    c.b0 = b0 * a0Inv;
+    c.b1 = b1 * a0Inv;
+    c.b2 = b2 * a0Inv;
+    c.a1 = a1 * a0Inv;
+    c.a2 = a2 * a0Inv;
+}
+
+// Mirrors IIR::Coefficients::makeHighPass
+static void designHighPassSection(BiquadCoefficients& c, double sampleRate, double frequency, double Q)
+{
+    auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / Q;
+    auto c1 = 1.0 / (1.0 + n * invQ + nSquared);
+
+    setNormalised(c, c1, c1 * -2.0, c1,
+        1.0, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - n * invQ + nSquared));
+}
+
+// Mirrors IIR::Coefficients::makeLowPass
+static void designLowPassSection(BiquadCoefficients& c, double sampleRate, double frequency, double Q)
+{
+    auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / Q;
+    auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    setNormalised(c, c1, c1 * 2.0, c1,
+        1.0, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared));
+}
+
+// Q of each section of an even order Butterworth cascade, as in FilterDesign
+static double getButterworthQ(int section, int order)
+{
+    return 1.0 / (2.0 * std::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+}
+
+bool isBandFlat(const BandSettings& bandSettings)
+{
+    switch (bandSettings.type)
+    {
+        case Band_Off:   return true;
+        case Band_Notch: return false;
+        default:         return std::abs(bandSettings.gainInDecibels) < 0.01f;
+    }
+}
+
+// These match the limits of the "LowCut Freq" and "HighCut Freq" ranges
+bool isLowCutOpen(const ChainSettings& chainSettings)
+{
+    return chainSettings.lowCutFreq <= 20.f;
+}
+
+bool isHighCutOpen(const ChainSettings& chainSettings)
+{
+    return chainSettings.highCutFreq >= 20000.f;
+}
+
+// Mirrors IIR::Coefficients::makePeakFilter
+static void designPeakSection(BiquadCoefficients& c, double sampleRate, double frequency, double Q, double gainFactor)
+{
+    auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    auto omega = (juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0)) / sampleRate;
+    auto alpha = std::sin(omega) / (Q * 2.0);
+    auto c2 = -2.0 * std::cos(omega);
+    auto alphaTimesA = alpha * A;
+    auto alphaOverA = alpha / A;
+
+    setNormalised(c, 1.0 + alphaTimesA, c2, 1.0 - alphaTimesA,
+        1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+// Mirrors IIR::Coefficients::makeLowShelf and makeHighShelf
+static void designShelfSection(BiquadCoefficients& c, double sampleRate, double frequency, double Q, double gainFactor,
+    bool highShelf)
+{
+    auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    auto aminus1 = A - 1.0;
+    auto aplus1 = A + 1.0;
+    auto omega = (juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0)) / sampleRate;
+    auto coso = std::cos(omega);
+    auto beta = std::sin(omega) * std::sqrt(A) / Q;
+    auto aminus1TimesCoso = aminus1 * coso;
+
+    if (highShelf)
+        setNormalised(c, A * (aplus1 + aminus1TimesCoso + beta),
+            A * -2.0 * (aminus1 + aplus1 * coso),
+            A * (aplus1 + aminus1TimesCoso - beta),
+            aplus1 - aminus1TimesCoso + beta,
+            2.0 * (aminus1 - aplus1 * coso),
+            aplus1 - aminus1TimesCoso - beta);
+    else
+        setNormalised(c, A * (aplus1 - aminus1TimesCoso + beta),
+            A * 2.0 * (aminus1 - aplus1 * coso),
+            A * (aplus1 - aminus1TimesCoso - beta),
+            aplus1 + aminus1TimesCoso + beta,
+            -2.0 * (aminus1 + aplus1 * coso),
+            aplus1 + aminus1TimesCoso - beta);
+}
+
+// Mirrors IIR::Coefficients::makeNotch
+static void designNotchSection(BiquadCoefficients& c, double sampleRate, double frequency, double Q)
+{
+    auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / Q;
+    auto c1 = 1.0 / (1.0 + n * invQ + nSquared);
+    auto b0 = c1 * (1.0 + nSquared);
+    auto b1 = 2.0 * c1 * (1.0 - nSquared);
+
+    setNormalised(c, b0, b1, b0, 1.0, b1, c1 * (1.0 - n * invQ + nSquared));
+}
+
+void designBandFilter(BiquadCoefficients& coefficients, const BandSettings& bandSettings, double sampleRate)
+{
+    auto frequency = static_cast<double>(bandSettings.freq);
+    auto quality = static_cast<double>(bandSettings.quality);
+    auto gainFactor = static_cast<double>(juce::Decibels::decibelsToGain(bandSettings.gainInDecibels));
+
+    switch (bandSettings.type)
+    {
+        case Band_Peak:      designPeakSection(coefficients, sampleRate, frequency, quality, gainFactor); break;
+        case Band_LowShelf:  designShelfSection(coefficients, sampleRate, frequency, quality, gainFactor, false); break;
+        case Band_HighShelf: designShelfSection(coefficients, sampleRate, frequency, quality, gainFactor, true); break;
+        case Band_Notch:     designNotchSection(coefficients, sampleRate, frequency, quality); break;
+        default:             coefficients = {}; break;
+    }
+}
+
+void designLowCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+    auto order = 2 * (chainSettings.lowCutSlope + 1);
+
+    for (int i = 0; i < order / 2; ++i)
+        designHighPassSection(coefficients.sections[i], sampleRate, chainSettings.lowCutFreq, getButterworthQ(i, order));
+
+    coefficients.slope = chainSettings.lowCutSlope;
+    coefficients.bypassed = isLowCutOpen(chainSettings);
+}
+
+void designHighCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+    auto order = 2 * (chainSettings.highCutSlope + 1);
+
+    for (int i = 0; i < order / 2; ++i)
+        designLowPassSection(coefficients.sections[i], sampleRate, chainSettings.highCutFreq, getButterworthQ(i, order));
+
+    coefficients.slope = chainSettings.highCutSlope;
+    coefficients.bypassed = isHighCutOpen(chainSettings);
+}
+
+//==============================================================================
+// Samples for the impulse response of one section to fall by the given factor,
+// from the largest pole radius
+static double getDecayLengthInSamples(const BiquadCoefficients& c, double attenuation)
+{
+    // Poles of z^2 + a1 z + a2
+    auto discriminant = c.a1 * c.a1 - 4.0 * c.a2;
+    double radius = 0.0;
+
+    if (discriminant < 0.0)
+    {
+        radius = std::sqrt(c.a2);
+    }
+    else
+    {
+        auto root = std::sqrt(discriminant);
+        radius = juce::jmax(std::abs(-c.a1 + root), std::abs(-c.a1 - root)) * 0.5;
+    }
+
+    if (radius <= 0.0)
+        return 2.0;
+
+    // Marginally stable, which the designs never are: report a long tail rather than forever
+    if (radius >= 1.0)
+        return std::numeric_limits<double>::max();
+
+    return std::log(attenuation) / std::log(radius);
+}
+
+double getTailLengthInSamples(const ChainCoefficients& coefficients)
+{
+    constexpr auto attenuation = 1.0e-5;
+
+    // A cascade rings for at most the sum of its sections
+    double tail = 0.0;
+
+    auto addCut = [&](const CutCoefficients& cut)
+    {
+        if (!cut.bypassed)
+            for (int i = 0; i <= cut.slope; ++i)
+                tail += getDecayLengthInSamples(cut.sections[static_cast<size_t>(i)], attenuation);
+    };
+
+    addCut(coefficients.lowCut);
+    addCut(coefficients.highCut);
+
+    for (const auto& band : coefficients.bands)
+        if (!band.bypassed)
+            tail += getDecayLengthInSamples(band.section, attenuation);
+
+    return tail;
+}
+
+//==============================================================================
+int getChangedBands(const ChainSettings& a, const ChainSettings& b)
+{
+    int bands = 0;
+
+    if (a.lowCutFreq != b.lowCutFreq || a.lowCutSlope != b.lowCutSlope)
+        bands |= CoefficientEngine::LowCutBand;
+
+    if (a.highCutFreq != b.highCutFreq || a.highCutSlope != b.highCutSlope)
+        bands |= CoefficientEngine::HighCutBand;
+
+    for (size_t i = 0; i < a.bands.size(); ++i)
+    {
+        const auto& x = a.bands[i];
+        const auto& y = b.bands[i];
+
+        if (x.type != y.type || x.freq != y.freq || x.gainInDecibels != y.gainInDecibels || x.quality != y.quality)
+            bands |= CoefficientEngine::getParametricBand(static_cast<int>(i));
+    }
+
+    return bands;
+}
+
+//==============================================================================
+// The bands each of the cut and oversampling parameters affects. The
+// parametric bands' own parameters are looked up in ParamIDs::bands.
+static const struct
+{
+    const char* parameterID;
+    int bands;
+} parameterBands[] =
+{
+    { ParamIDs::lowCutFreq,   CoefficientEngine::LowCutBand },
+    { ParamIDs::lowCutSlope,  CoefficientEngine::LowCutBand },
+    { ParamIDs::highCutFreq,  CoefficientEngine::HighCutBand },
+    { ParamIDs::highCutSlope, CoefficientEngine::HighCutBand },
+
+    // Everything is designed for the oversampled rate
+    { ParamIDs::oversampling, CoefficientEngine::AllBands }
+};
+
+template<typename Fn>
+static void forEachParameter(Fn&& fn)
+{
+    for (const auto& p : parameterBands)
+        fn(p.parameterID, p.bands);
+
+    for (int i = 0; i < numParametricBands; ++i)
+    {
+        const auto& ids = ParamIDs::bands[i];
+        auto band = CoefficientEngine::getParametricBand(i);
+
+        for (auto* parameterID : { ids.type, ids.freq, ids.gain, ids.quality })
+            fn(parameterID, band);
+    }
+}
+
+CoefficientEngine::CoefficientEngine(juce::AudioProcessorValueTreeState& state) :
+    apvts(state), parameters(state)
+{
+    forEachParameter([this](const char* parameterID, int) { apvts.addParameterListener(parameterID, this); });
+
+    workerThread->addTimeSliceClient(this);
+}
+
+CoefficientEngine::~CoefficientEngine()
+{
+    // Blocks until the worker is out of update()
+    workerThread->removeTimeSliceClient(this);
+
+    forEachParameter([this](const char* parameterID, int) { apvts.removeParameterListener(parameterID, this); });
+}
+
+void CoefficientEngine::prepare(double newSampleRate)
+{
+    {
+        const juce::ScopedLock sl(designLock);
+        sampleRate = newSampleRate;
+    }
+
+    invalidate();
+    update();
+}
+
+void CoefficientEngine::invalidate(int bands)
+{
+    dirtyBands.fetch_or(bands);
+}
+
+void CoefficientEngine::setUsingWorker(bool shouldUseWorker)
+{
+    if (usingWorker == shouldUseWorker)
+        return;
+
+    usingWorker = shouldUseWorker;
+
+    // Removing blocks until the worker is out of update()
+    if (shouldUseWorker)
+        workerThread->addTimeSliceClient(this);
+    else
+        workerThread->removeTimeSliceClient(this);
+}
+
+void CoefficientEngine::setCacheWarmingFactor(int factor)
+{
+    // The cache may not have the current designs for the new rate yet
+    if (cacheWarmingFactor.exchange(factor) != factor && factor > 0)
+        invalidate();
+}
+
+static void designBands(CoefficientCache& cache, ChainCoefficients& coefficients, int bands,
+    const ChainSettings& chainSettings, double sampleRate)
+{
+    if (bands & CoefficientEngine::LowCutBand)
+        cache.designLowCutFilter(coefficients.lowCut, chainSettings, sampleRate, CoefficientCache::FindOrInsert);
+
+    if (bands & CoefficientEngine::HighCutBand)
+        cache.designHighCutFilter(coefficients.highCut, chainSettings, sampleRate, CoefficientCache::FindOrInsert);
+
+    for (int i = 0; i < numParametricBands; ++i)
+        if (bands & CoefficientEngine::getParametricBand(i))
+            cache.designBandFilter(coefficients.bands[static_cast<size_t>(i)], chainSettings.bands[static_cast<size_t>(i)],
+                sampleRate, CoefficientCache::FindOrInsert);
+}
+
+int CoefficientEngine::update()
+{
+    // Steady state: nothing moved, so there is nothing to design
+    if (dirtyBands.load(std::memory_order_relaxed) == 0)
+        return 0;
+
+    const juce::ScopedLock sl(designLock);
+
+    if (sampleRate <= 0.0)
+        return 0;
+
+    // Clear the flags before reading the parameters, so a change that lands
+    // while we are designing is picked up by the next update
+    auto bands = dirtyBands.exchange(0);
+    auto chainSettings = parameters.getChainSettings();
+
+    coefficients.oversamplingFactor = parameters.getOversamplingFactor();
+    auto designSampleRate = sampleRate * coefficients.oversamplingFactor;
+
+    designBands(*cache, coefficients, bands, chainSettings, designSampleRate);
+
+    // Only the settled targets go in, never the steps of a ramp
+    auto warmingFactor = cacheWarmingFactor.load(std::memory_order_relaxed);
+
+    if (warmingFactor > 0 && warmingFactor != coefficients.oversamplingFactor)
+        designBands(*cache, warmedCoefficients, bands, chainSettings, sampleRate * warmingFactor);
+
+    published.getWriteBuffer() = coefficients;
+    published.publish();
+
+    numRedesigns.fetch_add(1, std::memory_order_relaxed);
+
+    // Capped, in case a section ends up (close to) marginally stable
+    tailLengthSeconds.store(juce::jmin(getTailLengthInSamples(coefficients) / designSampleRate, 10.0));
+
+    snapshot.coefficients = coefficients;
+    snapshot.sampleRate = designSampleRate;
+    ++snapshot.version;
+
+    if (bands & LowCutBand)
+        ++snapshot.lowCutVersion;
+
+    if (bands & HighCutBand)
+        ++snapshot.highCutVersion;
+
+    for (int i = 0; i < numParametricBands; ++i)
+        if (bands & getParametricBand(i))
+            ++snapshot.bandVersions[static_cast<size_t>(i)];
+
+    snapshots.getWriteBuffer() = snapshot;
+    snapshots.publish();
+
+    sendChangeMessage();
+
+    return bands;
+}
+
+int CoefficientEngine::useTimeSlice()
+{
+    // Poll quickly while parameters are moving, and back off when they aren't
+    return update() != 0 ? 1 : 5;
+}
+
+void CoefficientEngine::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(newValue);
+
+    int bands = 0;
+
+    forEachParameter([&](const char* id, int flags)
+    {
+        if (parameterID == id)
+            bands |= flags;
+    });
+
+    invalidate(bands);
+}
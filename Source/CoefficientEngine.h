@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    CoefficientEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "Parameters.h"
+#include "TripleBuffer.h"
+#include "WorkerThread.h"
+
+#include <array>
+#include <atomic>
+
+class CoefficientCache;
+
+// Coefficients of a single second order section, normalised so that a0 == 1.
+// This is the same layout as the 5 values held by a biquad IIR::Coefficients.
+// Kept in double so each engine can round them to its own precision.
+struct BiquadCoefficients
+{
+    double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+};
+
+// A cut filter is a cascade of up to 4 Butterworth sections (48 db/Oct)
+struct CutCoefficients
+{
+    std::array<BiquadCoefficients, 4> sections;
+    Slope slope{ Slope::Slope_12 };
+
+    // Set when the corner sits at the end of the parameter range
+    bool bypassed{ false };
+};
+
+// One parametric band: a single section, skipped while bypassed
+struct BandCoefficients
+{
+    BiquadCoefficients section;
+
+    // Set when the band is off, or its gain is 0 dB
+    bool bypassed{ true };
+};
+
+struct ChainCoefficients
+{
+    CutCoefficients lowCut;
+    std::array<BandCoefficients, numParametricBands> bands;
+    CutCoefficients highCut;
+
+    // The set was designed for this multiple of the host sample rate
+    int oversamplingFactor{ 1 };
+};
+
+// What the editor draws from: the last published set, with the rate it was
+// designed for. The versions go up each time the whole set / a band is redesigned.
+struct CoefficientSnapshot
+{
+    ChainCoefficients coefficients;
+    double sampleRate{ 0.0 };
+
+    juce::uint32 version{ 0 };
+    juce::uint32 lowCutVersion{ 0 }, highCutVersion{ 0 };
+    std::array<juce::uint32, numParametricBands> bandVersions{};
+};
+
+// Stages that leave the signal (close to) untouched and can be skipped
+bool isBandFlat(const BandSettings& bandSettings);
+bool isLowCutOpen(const ChainSettings& chainSettings);
+bool isHighCutOpen(const ChainSettings& chainSettings);
+
+// Same designs as makeBandFilter/makeLowCutFilter/makeHighCutFilter, but written
+// into existing storage so that they never allocate.
+void designBandFilter(BiquadCoefficients& coefficients, const BandSettings& bandSettings, double sampleRate);
+void designLowCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate);
+void designHighCutFilter(CutCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate);
+
+// How long the chain rings after its input stops, until it is 100 dB down,
+// in samples at the rate it was designed for. Estimated from the pole radius
+// of each active section, so it follows the lowest cut and its slope as well
+// as any narrow band.
+double getTailLengthInSamples(const ChainCoefficients& coefficients);
+
+// The CoefficientEngine::Band flags whose settings differ between a and b
+int getChangedBands(const ChainSettings& a, const ChainSettings& b);
+
+//==============================================================================
+/**
+    Designs the chain coefficients on the shared WorkerThread and publishes
+    finished sets to the audio thread through a TripleBuffer.
+
+    The "Oversampling" parameter is picked up here too: each set is designed for
+    the oversampled rate and says which factor it was made for, so the audio
+    thread switches oversampling exactly when matching coefficients arrive.
+
+    The APVTS listener just sets a dirty bit per band, so it is cheap to call from
+    whichever thread the host changes parameters on. The worker only redesigns the
+    bands whose parameters moved, and the audio thread only ever swaps a pointer.
+    The editor gets its own copy of every set, so it never designs anything.
+    A change message is sent whenever a snapshot is published.
+*/
+class CoefficientEngine : public juce::ChangeBroadcaster,
+    private juce::AudioProcessorValueTreeState::Listener,
+    private juce::TimeSliceClient
+{
+public:
+    enum Band
+    {
+        LowCutBand         = 1 << 0,
+        HighCutBand        = 1 << 1,
+        AllParametricBands = ((1 << numParametricBands) - 1) << 2,
+        AllBands           = LowCutBand | HighCutBand | AllParametricBands
+    };
+
+    // The flag of one parametric band, for 0 <= index < numParametricBands
+    static constexpr int getParametricBand(int index) { return 1 << (2 + index); }
+
+    CoefficientEngine(juce::AudioProcessorValueTreeState& apvts);
+    ~CoefficientEngine() override;
+
+    // Designs and publishes a full set synchronously, so the first block after
+    // prepareToPlay already has valid coefficients. Takes the host sample rate.
+    void prepare(double sampleRate);
+
+    // Forces the given bands to be redesigned by the next update()
+    void invalidate(int bands = AllBands);
+
+    // While factor > 0, each update() also stores the designs for factor times the
+    // host rate in the shared cache, for a path that only looks them up on the
+    // audio thread. Safe to call from there.
+    void setCacheWarmingFactor(int factor);
+
+    // Takes the engine off the shared worker, or puts it back. While it is off,
+    // nothing is designed unless the caller runs update(), as the benchmark does
+    // to time it on its own. Message thread only.
+    void setUsingWorker(bool shouldUseWorker);
+
+    // Redesigns the dirty bands and publishes the result. Only the worker,
+    // prepare() and a caller that took the engine off the worker call it, so
+    // the buffers always have a single writer.
+    // Returns the Band flags that changed.
+    int update();
+
+    // Audio thread: returns true if a newer set was published since the last call
+    bool acquire() { return published.acquire(); }
+    const ChainCoefficients& getPublishedCoefficients() const { return published.getReadBuffer(); }
+
+    // Message thread: same as above, for the one editor that draws the curve
+    bool acquireSnapshot() { return snapshots.acquire(); }
+    const CoefficientSnapshot& getSnapshot() const { return snapshots.getReadBuffer(); }
+
+    // How many sets have been designed so far, from any thread
+    juce::uint32 getNumRedesigns() const { return numRedesigns.load(std::memory_order_relaxed); }
+
+    // The tail of the last published set, from any thread
+    double getTailLengthSeconds() const { return tailLengthSeconds.load(std::memory_order_relaxed); }
+
+private:
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    int useTimeSlice() override;
+
+    juce::AudioProcessorValueTreeState& apvts;
+    ParameterBindings parameters;
+
+    std::atomic<int> dirtyBands{ AllBands };
+    std::atomic<juce::uint32> numRedesigns{ 0 };
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+    std::atomic<int> cacheWarmingFactor{ 0 };
+    double sampleRate{ 0.0 };
+    bool usingWorker{ true };
+
+    // Only touched with the lock held: the worker and prepare() can both design
+    juce::CriticalSection designLock;
+    ChainCoefficients coefficients, warmedCoefficients;
+
+    TripleBuffer<ChainCoefficients> published;
+
+    CoefficientSnapshot snapshot;
+    TripleBuffer<CoefficientSnapshot> snapshots;
+
+    juce::SharedResourcePointer<WorkerThread> workerThread;
+
+    // Shared by every instance, so a design one of them made is found by the others
+    juce::SharedResourcePointer<CoefficientCache> cache;
+};
@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    Instrumentation.cpp
+
+  ==============================================================================
+*/
+
+#include "Instrumentation.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+void BlockStatsRing::push(const BlockStats& newStats)
+{
+    const auto scope = fifo.write(1);
+
+    if (scope.blockSize1 > 0)
+        stats[static_cast<size_t>(scope.startIndex1)] = newStats;
+}
+
+int BlockStatsRing::pop(BlockStats* dest, int maxNumStats)
+{
+    const auto scope = fifo.read(juce::jmin(maxNumStats, fifo.getNumReady()));
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        dest[i] = stats[static_cast<size_t>(scope.startIndex1 + i)];
+
+    for (int i = 0; i < scope.blockSize2; ++i)
+        dest[scope.blockSize1 + i] = stats[static_cast<size_t>(scope.startIndex2 + i)];
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+void BlockStatsRing::clear()
+{
+    // Only the reader's position moves, so this is safe while the audio thread pushes
+    fifo.read(fifo.getNumReady());
+}
+
+float ticksToMicroseconds(juce::int64 ticks)
+{
+    return static_cast<float>(juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6);
+}
+
+//==============================================================================
+// The counter of the innermost ScopedAllocationCounter on this thread, if any.
+// A plain pointer, so reading it from operator new never allocates itself.
+static thread_local juce::uint32* activeAllocationCounter = nullptr;
+
+ScopedAllocationCounter::ScopedAllocationCounter()
+{
+   #if SIMPLEEQ_DETECT_ALLOCATIONS
+    previous = activeAllocationCounter;
+    activeAllocationCounter = &count;
+   #endif
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter()
+{
+   #if SIMPLEEQ_DETECT_ALLOCATIONS
+    activeAllocationCounter = previous;
+
+    if (previous != nullptr)
+        *previous += count;
+   #endif
+}
+
+#if SIMPLEEQ_DETECT_ALLOCATIONS
+static void* allocate(std::size_t size) noexcept
+{
+    if (activeAllocationCounter != nullptr)
+        ++*activeAllocationCounter;
+
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+// Over-allocates with malloc and keeps the pointer to free just before the
+// aligned block, so this works wherever std::aligned_alloc doesn't
+static void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+{
+    const auto align = juce::jmax(static_cast<std::size_t>(alignment), sizeof(void*));
+
+    auto* raw = static_cast<char*>(allocate(size + align + sizeof(void*)));
+
+    if (raw == nullptr)
+        return nullptr;
+
+    auto address = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+    auto* aligned = reinterpret_cast<char*>((address + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1));
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return aligned;
+}
+
+static void freeAligned(void* p) noexcept
+{
+    if (p != nullptr)
+        std::free(static_cast<void**>(p)[-1]);
+}
+
+void* operator new(std::size_t size)
+{
+    if (auto* p = allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* p = allocateAligned(size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+#endif
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    Instrumentation.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+// Counting allocations means replacing the global operator new for the whole
+// process, which a plugin must never do inside someone else's host. So it is
+// only compiled into projects that define this to 1, like the benchmark, and
+// the plugin's allocation counts always read 0.
+#ifndef SIMPLEEQ_DETECT_ALLOCATIONS
+ #define SIMPLEEQ_DETECT_ALLOCATIONS 0
+#endif
+
+// What one processBlock call cost
+struct BlockStats
+{
+    // Picking up / designing coefficients, running the filters (including
+    // oversampling), and the whole call
+    float updateMicroseconds{ 0.f }, filterMicroseconds{ 0.f }, blockMicroseconds{ 0.f };
+
+    // blockMicroseconds as a proportion of the audio the block holds
+    float load{ 0.f };
+
+    int numSamples{ 0 };
+
+    // Coefficient sets designed for this block: by the worker since the last
+    // block, plus the ones designed on the audio thread while smoothing
+    juce::uint32 redesigns{ 0 };
+
+    // Always 0 unless SIMPLEEQ_DETECT_ALLOCATIONS is on, so always 0 in the plugin
+    juce::uint32 allocations{ 0 };
+};
+
+/**
+    Preallocated ring of BlockStats, written by the audio thread and read by
+    the message thread. push() never blocks or allocates: when the reader falls
+    behind (or there is none) the newest records are dropped.
+*/
+class BlockStatsRing
+{
+public:
+    static constexpr int capacity = 1024;
+
+    // Audio thread
+    void push(const BlockStats& stats);
+
+    // Message thread: copies up to maxNumStats of the oldest records into dest
+    // and returns how many it copied
+    int pop(BlockStats* dest, int maxNumStats);
+
+    // Message thread: throws away everything waiting
+    void clear();
+
+private:
+    juce::AbstractFifo fifo{ capacity };
+    std::array<BlockStats, capacity> stats;
+};
+
+// Measures the time spent in a scope with the high resolution clock,
+// adding it to a running total of ticks
+struct ScopedTicks
+{
+    explicit ScopedTicks(juce::int64& totalToAddTo) :
+        total(totalToAddTo), start(juce::Time::getHighResolutionTicks()) {}
+
+    ~ScopedTicks() { total += juce::Time::getHighResolutionTicks() - start; }
+
+    juce::int64& total;
+    juce::int64 start;
+};
+
+float ticksToMicroseconds(juce::int64 ticks);
+
+/**
+    Counts the allocations made on the calling thread while it exists. Counters
+    can be nested: an inner one's count is added to the outer one when it ends.
+    getCount() is always 0 when SIMPLEEQ_DETECT_ALLOCATIONS is off.
+*/
+struct ScopedAllocationCounter
+{
+    ScopedAllocationCounter();
+    ~ScopedAllocationCounter();
+
+    juce::uint32 getCount() const { return count; }
+
+    static constexpr bool isEnabled() { return SIMPLEEQ_DETECT_ALLOCATIONS != 0; }
+
+private:
+    juce::uint32 count{ 0 };
+    juce::uint32* previous{ nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllocationCounter)
+};
@@ -0,0 +1,367 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEngine.h"
+
+// Long enough for a 20 Hz low cut at the rates we expect, the latency being
+// half of it: 8191 taps up to 48 kHz, 16383 up to 96 kHz, 32767 above
+static int getKernelOrder(double sampleRate)
+{
+    if (sampleRate <= 50000.0)
+        return 13;
+
+    return sampleRate <= 100000.0 ? 14 : 15;
+}
+
+//==============================================================================
+void UniformConvolver::prepare(int numChannels, int maxKernelSize)
+{
+    maxNumPartitions = juce::jmax(1, (maxKernelSize + partitionSize - 1) / partitionSize);
+    kernel.assign(static_cast<size_t>(maxNumPartitions * numBins), {});
+    numPartitions = 0;
+
+    channels.resize(static_cast<size_t>(numChannels));
+
+    for (auto& channel : channels)
+    {
+        channel.segment.assign(static_cast<size_t>(fftSize), 0.f);
+        channel.history.assign(static_cast<size_t>(maxNumPartitions * numBins), {});
+        channel.accumulated.assign(static_cast<size_t>(numBins), {});
+    }
+
+    fftBuffer.assign(static_cast<size_t>(fftSize * 2), 0.f);
+    spectrum.assign(static_cast<size_t>(fftSize), {});
+
+    reset();
+}
+
+void UniformConvolver::reset()
+{
+    for (auto& channel : channels)
+    {
+        std::fill(channel.segment.begin(), channel.segment.end(), 0.f);
+        std::fill(channel.history.begin(), channel.history.end(), Complex());
+        std::fill(channel.accumulated.begin(), channel.accumulated.end(), Complex());
+        channel.head = 0;
+    }
+
+    position = 0;
+}
+
+void UniformConvolver::setKernel(const float* taps, int numTaps)
+{
+    jassert(numTaps <= maxNumPartitions * partitionSize);
+    numPartitions = juce::jmin(maxNumPartitions, (numTaps + partitionSize - 1) / partitionSize);
+
+    for (int k = 0; k < numPartitions; ++k)
+    {
+        auto start = k * partitionSize;
+        auto length = juce::jmin(partitionSize, numTaps - start);
+
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.f);
+        std::copy(taps + start, taps + start + length, fftBuffer.begin());
+        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        auto* bins = reinterpret_cast<const Complex*>(fftBuffer.data());
+        std::copy(bins, bins + numBins, kernel.begin() + k * numBins);
+    }
+
+    // The older input meets the new kernel straight away
+    for (auto& channel : channels)
+        accumulate(channel);
+}
+
+void UniformConvolver::accumulate(Channel& channel)
+{
+    auto* sum = channel.accumulated.data();
+    std::fill(sum, sum + numBins, Complex());
+
+    // history[head] is the segment that was filled last, i.e. the input one
+    // partition back, which meets the second partition of the kernel
+    for (int k = 1; k < numPartitions; ++k)
+    {
+        auto index = (channel.head + k - 1) % maxNumPartitions;
+        auto* x = channel.history.data() + index * numBins;
+        auto* h = kernel.data() + k * numBins;
+
+        for (int bin = 0; bin < numBins; ++bin)
+            sum[bin] += x[bin] * h[bin];
+    }
+}
+
+void UniformConvolver::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    auto numChannels = juce::jmin(block.getNumChannels(), channels.size());
+    auto numSamples = static_cast<int>(block.getNumSamples());
+
+    auto startPosition = position;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        processChannel(channels[ch], block.getChannelPointer(ch), numSamples, startPosition);
+
+    for (size_t ch = numChannels; ch < block.getNumChannels(); ++ch)
+        block.getSingleChannelBlock(ch).clear();
+
+    position = (startPosition + numSamples) % partitionSize;
+}
+
+void UniformConvolver::processChannel(Channel& channel, float* data, int numSamples, int startPosition)
+{
+    auto channelPosition = startPosition;
+
+    for (int done = 0; done < numSamples;)
+    {
+        auto length = juce::jmin(numSamples - done, partitionSize - channelPosition);
+        std::copy(data + done, data + done + length, channel.segment.begin() + partitionSize + channelPosition);
+
+        // Overlap-save: the not yet filled end of the segment is zero, which
+        // only affects outputs we haven't got to
+        std::copy(channel.segment.begin(), channel.segment.end(), fftBuffer.begin());
+        std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.f);
+        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        auto* x = reinterpret_cast<const Complex*>(fftBuffer.data());
+
+        if (numPartitions > 0)
+        {
+            for (int bin = 0; bin < numBins; ++bin)
+                spectrum[static_cast<size_t>(bin)] = channel.accumulated[static_cast<size_t>(bin)] + x[bin] * kernel[static_cast<size_t>(bin)];
+        }
+        else
+        {
+            std::fill(spectrum.begin(), spectrum.begin() + numBins, Complex());
+        }
+
+        // Whole segment filled: it joins the history before the buffer is reused
+        if (channelPosition + length == partitionSize)
+        {
+            channel.head = (channel.head + maxNumPartitions - 1) % maxNumPartitions;
+            std::copy(x, x + numBins, channel.history.begin() + channel.head * numBins);
+        }
+
+        // The inverse wants the negative frequencies too
+        for (int bin = numBins; bin < fftSize; ++bin)
+            spectrum[static_cast<size_t>(bin)] = std::conj(spectrum[static_cast<size_t>(fftSize - bin)]);
+
+        auto* y = reinterpret_cast<const float*>(spectrum.data());
+        std::copy(y, y + fftSize * 2, fftBuffer.begin());
+        fft.performRealOnlyInverseTransform(fftBuffer.data());
+
+        std::copy(fftBuffer.begin() + partitionSize + channelPosition,
+            fftBuffer.begin() + partitionSize + channelPosition + length, data + done);
+
+        channelPosition += length;
+        done += length;
+
+        if (channelPosition == partitionSize)
+        {
+            std::copy(channel.segment.begin() + partitionSize, channel.segment.end(), channel.segment.begin());
+            std::fill(channel.segment.begin() + partitionSize, channel.segment.end(), 0.f);
+            channelPosition = 0;
+
+            accumulate(channel);
+        }
+    }
+}
+
+//==============================================================================
+bool LinearPhaseEngine::KernelState::needsUpdate(const ChainSettings& chainSettings, int factor) const
+{
+    return needsKernel || factor != oversamplingFactor || getChangedBands(settings, chainSettings) != 0;
+}
+
+void LinearPhaseEngine::KernelState::set(const ChainSettings& chainSettings, int factor)
+{
+    settings = chainSettings;
+    oversamplingFactor = factor;
+    needsKernel = false;
+}
+
+LinearPhaseEngine::LinearPhaseEngine(juce::AudioProcessorValueTreeState& apvts) :
+    parameters(apvts)
+{
+    workerThread->addTimeSliceClient(this);
+}
+
+LinearPhaseEngine::~LinearPhaseEngine()
+{
+    // Blocks until the worker is out of update()
+    workerThread->removeTimeSliceClient(this);
+}
+
+void LinearPhaseEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    {
+        const juce::ScopedLock sl(designLock);
+
+        sampleRate = spec.sampleRate;
+
+        auto order = getKernelOrder(sampleRate);
+        fftSize = 1 << order;
+        fft = std::make_unique<juce::dsp::FFT>(order);
+        fftData.assign(static_cast<size_t>(fftSize * 2), 0.f);
+
+        // An odd number of taps, so the kernel is symmetric around a whole sample
+        auto numTaps = fftSize - 1;
+        window.resize(static_cast<size_t>(numTaps));
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), static_cast<size_t>(numTaps),
+            juce::dsp::WindowingFunction<float>::blackman, false);
+
+        auto numBins = fftSize / 2 + 1;
+        binFrequencies.resize(static_cast<size_t>(numBins));
+        binDecibels.resize(static_cast<size_t>(numBins));
+
+        for (int i = 0; i < numBins; ++i)
+            binFrequencies[static_cast<size_t>(i)] = i * sampleRate / fftSize;
+
+        kernelTaps.resize(static_cast<size_t>(numTaps));
+
+        convolution.prepare(spec);
+        offlineConvolver.prepare(static_cast<int>(spec.numChannels), numTaps);
+
+        realtimeKernel.needsKernel = true;
+        offlineKernel.needsKernel = true;
+
+        // The offline convolver has none, so both paths report the same
+        jassert(convolution.getLatency() == 0);
+
+        latency.store(numTaps / 2 + convolution.getLatency());
+        tailLength.store(numTaps + convolution.getLatency());
+    }
+
+    update();
+}
+
+void LinearPhaseEngine::reset()
+{
+    convolution.reset();
+    offlineConvolver.reset();
+}
+
+void LinearPhaseEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (wasNonRealtime)
+    {
+        wasNonRealtime = false;
+        convolution.reset();
+    }
+
+    convolution.process(context);
+}
+
+void LinearPhaseEngine::processNonRealtime(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (!wasNonRealtime)
+    {
+        wasNonRealtime = true;
+        offlineConvolver.reset();
+    }
+
+    {
+        // Waits for the worker if it is building one, which a render can afford
+        const juce::ScopedLock sl(designLock);
+
+        auto chainSettings = parameters.getChainSettings();
+        auto oversamplingFactor = parameters.getOversamplingFactor();
+
+        if (sampleRate > 0.0 && offlineKernel.needsUpdate(chainSettings, oversamplingFactor))
+        {
+            buildKernel(chainSettings, oversamplingFactor);
+            offlineConvolver.setKernel(kernelTaps.data(), static_cast<int>(kernelTaps.size()));
+            offlineKernel.set(chainSettings, oversamplingFactor);
+        }
+    }
+
+    offlineConvolver.process(context);
+}
+
+bool LinearPhaseEngine::update()
+{
+    const juce::ScopedLock sl(designLock);
+
+    if (sampleRate <= 0.0)
+        return false;
+
+    auto chainSettings = parameters.getChainSettings();
+    auto oversamplingFactor = parameters.getOversamplingFactor();
+
+    if (!realtimeKernel.needsUpdate(chainSettings, oversamplingFactor))
+        return false;
+
+    buildKernel(chainSettings, oversamplingFactor);
+
+    juce::AudioBuffer<float> kernel(1, static_cast<int>(kernelTaps.size()));
+    kernel.copyFrom(0, 0, kernelTaps.data(), kernel.getNumSamples());
+
+    convolution.loadImpulseResponse(std::move(kernel), sampleRate,
+        juce::dsp::Convolution::Stereo::no, juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+
+    realtimeKernel.set(chainSettings, oversamplingFactor);
+
+    return true;
+}
+
+void LinearPhaseEngine::buildKernel(const ChainSettings& chainSettings, int oversamplingFactor)
+{
+    using namespace juce;
+
+    // The same designs the IIR path runs, so the magnitudes match it exactly
+    auto designSampleRate = sampleRate * oversamplingFactor;
+
+    cache->designLowCutFilter(coefficients.lowCut, chainSettings, designSampleRate, CoefficientCache::FindOrInsert);
+    cache->designHighCutFilter(coefficients.highCut, chainSettings, designSampleRate, CoefficientCache::FindOrInsert);
+
+    for (size_t i = 0; i < coefficients.bands.size(); ++i)
+        cache->designBandFilter(coefficients.bands[i], chainSettings.bands[i], designSampleRate, CoefficientCache::FindOrInsert);
+
+    // Both cuts at 48 dB/Oct, and every band
+    std::array<BiquadCoefficients, 8 + numParametricBands> sections;
+    int numSections = 0;
+
+    if (!coefficients.lowCut.bypassed)
+        for (int i = 0; i <= coefficients.lowCut.slope; ++i)
+            sections[numSections++] = coefficients.lowCut.sections[i];
+
+    for (const auto& band : coefficients.bands)
+        if (!band.bypassed)
+            sections[numSections++] = band.section;
+
+    if (!coefficients.highCut.bypassed)
+        for (int i = 0; i <= coefficients.highCut.slope; ++i)
+            sections[numSections++] = coefficients.highCut.sections[i];
+
+    responseEvaluator.prepare(binFrequencies.data(), static_cast<int>(binFrequencies.size()), designSampleRate);
+    responseEvaluator.computeResponse(sections.data(), numSections, binDecibels.data());
+
+    // Zero phase spectrum: the magnitudes as real parts, interleaved with zeros
+    std::fill(fftData.begin(), fftData.end(), 0.f);
+
+    for (size_t i = 0; i < binDecibels.size(); ++i)
+        fftData[i * 2] = Decibels::decibelsToGain(binDecibels[i]);
+
+    fft->performRealOnlyInverseTransform(fftData.data());
+
+    // The impulse is centred on sample 0 and wraps around, so rotate it to the
+    // middle of the kernel and taper the ends
+    auto numTaps = static_cast<int>(window.size());
+    auto centre = numTaps / 2;
+
+    for (int i = 0; i < numTaps; ++i)
+        kernelTaps[static_cast<size_t>(i)] = fftData[static_cast<size_t>((i - centre + fftSize) % fftSize)] * window[static_cast<size_t>(i)];
+}
+
+int LinearPhaseEngine::useTimeSlice()
+{
+    if (!enabled.load(std::memory_order_relaxed))
+        return 50;
+
+    // While a knob is moving, give the convolution time to swap and crossfade
+    // before queuing the next kernel
+    return update() ? 30 : 10;
+}
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "Parameters.h"
+#include "CoefficientEngine.h"
+#include "CoefficientCache.h"
+#include "ChainResponse.h"
+#include "WorkerThread.h"
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <vector>
+
+/**
+    Uniformly partitioned FFT convolution without latency, for offline renders.
+
+    Unlike juce::dsp::Convolution, a new kernel takes effect from the next
+    sample, without a background loader or a crossfade, so the output only
+    depends on the input and the kernels it was given. Nothing allocates
+    after prepare().
+*/
+class UniformConvolver
+{
+public:
+    // Room for kernels of up to maxKernelSize taps
+    void prepare(int numChannels, int maxKernelSize);
+    void reset();
+
+    void setKernel(const float* taps, int numTaps);
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    using Complex = std::complex<float>;
+
+    static constexpr int partitionOrder = 9;
+    static constexpr int partitionSize = 1 << partitionOrder;
+    static constexpr int fftSize = partitionSize * 2;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    struct Channel
+    {
+        // The previous partition of input and the one being filled
+        std::vector<float> segment;
+
+        // Spectra of the last segments that were filled, newest at head
+        std::vector<Complex> history;
+        int head{ 0 };
+
+        // What the older partitions of the kernel add to the current one
+        std::vector<Complex> accumulated;
+    };
+
+    void processChannel(Channel& channel, float* data, int numSamples, int startPosition);
+    void accumulate(Channel& channel);
+
+    juce::dsp::FFT fft{ partitionOrder + 1 };
+
+    // Each partition of the kernel, transformed
+    std::vector<Complex> kernel;
+    int numPartitions{ 0 }, maxNumPartitions{ 0 };
+
+    std::vector<Channel> channels;
+    int position{ 0 };
+
+    // Twice fftSize floats, as the FFT wants
+    std::vector<float> fftBuffer;
+    std::vector<Complex> spectrum;
+};
+
+/**
+    The "Linear Phase" mode: the magnitude response of the designed chain as a
+    symmetric FIR kernel, run through juce::dsp::Convolution.
+
+    Kernels are built on the shared WorkerThread, only while the mode is on and
+    only when the settings moved. The chain is designed for the oversampled rate
+    like the IIR path, so the kernel matches the curve the editor draws. Each new
+    kernel is handed to the convolution, which crossfades to it on its own.
+
+    Offline renders build the kernel on the render thread whenever the settings
+    moved and run it through a UniformConvolver instead, so a bounce follows
+    its automation exactly and the same way each time.
+
+    The kernel is delayed by half its length to make it causal, which is the
+    latency to report to the host.
+*/
+class LinearPhaseEngine : private juce::TimeSliceClient
+{
+public:
+    LinearPhaseEngine(juce::AudioProcessorValueTreeState& apvts);
+    ~LinearPhaseEngine() override;
+
+    // Sizes the kernel for the sample rate and builds the first one
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // Kernels are only built while this is on
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled); }
+
+    // Audio thread
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    // Render thread of an offline render: may block and design
+    void processNonRealtime(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    int getLatencyInSamples() const { return latency.load(std::memory_order_relaxed); }
+
+    // The whole kernel plus the convolution's own delay: how long an impulse
+    // takes to come out completely
+    int getTailLengthInSamples() const { return tailLength.load(std::memory_order_relaxed); }
+
+    // Builds a kernel for the current settings if they moved since the last one.
+    // Returns true if a new kernel was handed to the convolution.
+    bool update();
+
+private:
+    int useTimeSlice() override;
+
+    // Into kernelTaps
+    void buildKernel(const ChainSettings& chainSettings, int oversamplingFactor);
+
+    ParameterBindings parameters;
+
+    // The head is convolved in small partitions, the tail in bigger ones
+    juce::dsp::Convolution convolution{ juce::dsp::Convolution::NonUniform{ 512 } };
+
+    // Worker only, guarded against prepare() by the lock
+    juce::CriticalSection designLock;
+    double sampleRate{ 0.0 };
+    int fftSize{ 0 };
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData, window;
+    std::vector<double> binFrequencies;
+    std::vector<float> binDecibels;
+    ChainResponseEvaluator responseEvaluator;
+    ChainCoefficients coefficients;
+    std::vector<float> kernelTaps;
+
+    // Whatever the last kernel was built from, for the convolution and for
+    // the offline convolver
+    struct KernelState
+    {
+        ChainSettings settings;
+        int oversamplingFactor{ 0 };
+        bool needsKernel{ true };
+
+        bool needsUpdate(const ChainSettings& chainSettings, int factor) const;
+        void set(const ChainSettings& chainSettings, int factor);
+    };
+
+    KernelState realtimeKernel, offlineKernel;
+
+    UniformConvolver offlineConvolver;
+
+    // Audio thread: which of the two ran last, so the other starts from silence
+    bool wasNonRealtime{ false };
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<int> latency{ 0 }, tailLength{ 0 };
+
+    juce::SharedResourcePointer<WorkerThread> workerThread;
+    juce::SharedResourcePointer<CoefficientCache> cache;
+};
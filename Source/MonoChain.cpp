@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    MonoChain.cpp
+
+  ==============================================================================
+*/
+
+#include "MonoChain.h"
+
+template<typename SampleType>
+static void prepareFilterStorage(BasicFilter<SampleType>& filter)
+{
+    filter.coefficients = new juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+}
+
+template<typename SampleType>
+static void prepareCutFilterStorage(BasicCutFilter<SampleType>& cutFilter)
+{
+    prepareFilterStorage(cutFilter.template get<0>());
+    prepareFilterStorage(cutFilter.template get<1>());
+    prepareFilterStorage(cutFilter.template get<2>());
+    prepareFilterStorage(cutFilter.template get<3>());
+}
+
+template<typename SampleType>
+void prepareCoefficientStorage(BasicMonoChain<SampleType>& chain)
+{
+    prepareCutFilterStorage(chain.template get<ChainPositions::LowCut>());
+
+    for (auto& filter : chain.template get<ChainPositions::Bands>().filters)
+        prepareFilterStorage(filter);
+
+    prepareCutFilterStorage(chain.template get<ChainPositions::HighCut>());
+}
+
+template<typename SampleType>
+BasicCoefficients<SampleType> makeBandFilter(const BandSettings& bandSettings, double sampleRate)
+{
+	using Coefficients = juce::dsp::IIR::Coefficients<SampleType>;
+
+	auto gainFactor = static_cast<SampleType>(juce::Decibels::decibelsToGain(bandSettings.gainInDecibels));
+
+	switch (bandSettings.type)
+	{
+	case Band_Peak:
+		return Coefficients::makePeakFilter(sampleRate, bandSettings.freq, bandSettings.quality, gainFactor);
+	case Band_LowShelf:
+		return Coefficients::makeLowShelf(sampleRate, bandSettings.freq, bandSettings.quality, gainFactor);
+	case Band_HighShelf:
+		return Coefficients::makeHighShelf(sampleRate, bandSettings.freq, bandSettings.quality, gainFactor);
+	case Band_Notch:
+		return Coefficients::makeNotch(sampleRate, bandSettings.freq, bandSettings.quality);
+	default:
+		return new Coefficients(1, 0, 0, 1, 0, 0);
+	}
+}
+
+template<typename SampleType>
+void updateChain(BasicMonoChain<SampleType>& chain, const ChainSettings& chainSettings, double sampleRate)
+{
+	auto& bands = chain.template get<ChainPositions::Bands>();
+
+	for (size_t i = 0; i < bands.filters.size(); ++i)
+	{
+		const auto& bandSettings = chainSettings.bands[i];
+
+		updateCoefficients(bands.filters[i].coefficients, makeBandFilter<SampleType>(bandSettings, sampleRate));
+		bands.bypassed[i] = bandSettings.type == Band_Off;
+	}
+
+	auto lowCutCoefficients = makeLowCutFilter<SampleType>(chainSettings, sampleRate);
+	auto highCutCoefficients = makeHighCutFilter<SampleType>(chainSettings, sampleRate);
+
+	updateCutFilter(chain.template get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
+	updateCutFilter(chain.template get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+}
+
+template void prepareCoefficientStorage<float>(BasicMonoChain<float>&);
+template void prepareCoefficientStorage<double>(BasicMonoChain<double>&);
+template BasicCoefficients<float> makeBandFilter<float>(const BandSettings&, double);
+template BasicCoefficients<double> makeBandFilter<double>(const BandSettings&, double);
+template void updateChain<float>(BasicMonoChain<float>&, const ChainSettings&, double);
+template void updateChain<double>(BasicMonoChain<double>&, const ChainSettings&, double);
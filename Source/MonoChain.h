@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    MonoChain.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+
+template<typename SampleType>
+using BasicFilter = juce::dsp::IIR::Filter<SampleType>;
+
+// A single Filter has a 12 db/Oct slope. We need 4 if we want a max of 48 db/Oct
+template<typename SampleType>
+using BasicCutFilter = juce::dsp::ProcessorChain<BasicFilter<SampleType>, BasicFilter<SampleType>,
+	BasicFilter<SampleType>, BasicFilter<SampleType>>;
+
+// One Filter per parametric band. Bands that are off are skipped, so they cost nothing.
+template<typename SampleType>
+struct BasicBandFilters
+{
+	BasicBandFilters() { bypassed.fill(true); }
+
+	std::array<BasicFilter<SampleType>, numParametricBands> filters;
+	std::array<bool, numParametricBands> bypassed;
+
+	void prepare(const juce::dsp::ProcessSpec& spec)
+	{
+		for (auto& filter : filters)
+			filter.prepare(spec);
+	}
+
+	void reset()
+	{
+		for (auto& filter : filters)
+			filter.reset();
+	}
+
+	template<typename ProcessContext>
+	void process(const ProcessContext& context)
+	{
+		for (size_t i = 0; i < filters.size(); ++i)
+			if (!bypassed[i])
+				filters[i].process(context);
+	}
+};
+
+template<typename SampleType>
+using BasicMonoChain = juce::dsp::ProcessorChain<BasicCutFilter<SampleType>, BasicBandFilters<SampleType>,
+	BasicCutFilter<SampleType>>;
+
+template<typename SampleType>
+using BasicCoefficients = typename BasicFilter<SampleType>::CoefficientsPtr;
+
+// The float chain, which is what the editor and tools use
+using Filter = BasicFilter<float>;
+using CutFilter = BasicCutFilter<float>;
+using BandFilters = BasicBandFilters<float>;
+using MonoChain = BasicMonoChain<float>;
+using Coefficients = BasicCoefficients<float>;
+
+enum ChainPositions
+{
+	LowCut,
+	Bands,
+	HighCut
+};
+
+// Spelled out rather than BasicCoefficients, so SampleType can be deduced
+template<typename SampleType>
+void updateCoefficients(juce::ReferenceCountedObjectPtr<juce::dsp::IIR::Coefficients<SampleType>>& old,
+	const juce::ReferenceCountedObjectPtr<juce::dsp::IIR::Coefficients<SampleType>>& replacements)
+{
+	*old = *replacements;
+}
+
+// Gives every Filter in the chain its own second order Coefficients, so that
+// later updates can be written in place instead of allocating new objects
+template<typename SampleType>
+void prepareCoefficientStorage(BasicMonoChain<SampleType>& chain);
+
+// Peak, shelf or notch, from the IIR::Coefficients factories. "Off" bands get a
+// pass-through section.
+template<typename SampleType = float>
+BasicCoefficients<SampleType> makeBandFilter(const BandSettings& bandSettings, double sampleRate);
+
+template<int Index, typename ChainType, typename CoefficientType>
+void update(ChainType& chain, const CoefficientType& cutCoefficients)
+{
+	updateCoefficients(chain.template get<Index>().coefficients, cutCoefficients[Index]);
+	chain.template setBypassed<Index>(false);
+}
+
+template<typename ChainType, typename CoefficientType>
+void updateCutFilter(ChainType& leftLowCut,
+	const CoefficientType& cutCoefficients,
+	const Slope cutSlope)
+{
+	leftLowCut.template setBypassed<0>(true);
+	leftLowCut.template setBypassed<1>(true);
+	leftLowCut.template setBypassed<2>(true);
+	leftLowCut.template setBypassed<3>(true);
+
+	switch (cutSlope)
+	{
+	case Slope_48:
+	{
+		update<3>(leftLowCut, cutCoefficients);
+	}
+	case Slope_36:
+	{
+		update<2>(leftLowCut, cutCoefficients);
+	}
+	case Slope_24:
+	{
+		update<1>(leftLowCut, cutCoefficients);
+	}
+	case Slope_12:
+	{
+		update<0>(leftLowCut, cutCoefficients);
+	}
+	}
+}
+
+template<typename SampleType = float>
+auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+	return juce::dsp::FilterDesign<SampleType>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
+		sampleRate,
+		2 * (chainSettings.lowCutSlope + 1));
+}
+
+template<typename SampleType = float>
+auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+	return juce::dsp::FilterDesign<SampleType>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
+		sampleRate,
+		2 * (chainSettings.highCutSlope + 1));
+}
+
+// Designs every stage for the given settings with JUCE's IIR factories and
+// FilterDesign. The plugin runs CoefficientEngine's designs instead, which
+// also skip the flat bands and open cuts.
+template<typename SampleType>
+void updateChain(BasicMonoChain<SampleType>& chain, const ChainSettings& chainSettings, double sampleRate);
@@ -0,0 +1,307 @@
+/*
+  ==============================================================================
+
+    OpenGLResponseRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OpenGLResponseRenderer.h"
+
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+
+using namespace juce::gl;
+
+static const char* const vertexShaderSource =
+    "attribute vec2 position;\n"
+    "attribute float edge;\n"
+    "uniform vec2 viewportSize;\n"
+    "varying float edgeDistance;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    edgeDistance = edge;\n"
+    "    gl_Position = vec4(position.x / viewportSize.x * 2.0 - 1.0,\n"
+    "                       1.0 - position.y / viewportSize.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* const fragmentShaderSource =
+    "varying " JUCE_MEDIUMP " float edgeDistance;\n"
+    "uniform " JUCE_LOWP " vec4 colour;\n"
+    "uniform " JUCE_MEDIUMP " float halfWidth;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    // Fade out over the last device pixel on either side of the line
+    "    " JUCE_MEDIUMP " float alpha = clamp((1.0 - abs(edgeDistance)) * halfWidth, 0.0, 1.0);\n"
+    "    gl_FragColor = colour * alpha;\n"
+    "}\n";
+
+OpenGLResponseRenderer::OpenGLResponseRenderer(juce::Component& component) : target(component)
+{
+    context.setRenderer(this);
+    context.setComponentPaintingEnabled(false);
+    context.setContinuousRepainting(false);
+}
+
+OpenGLResponseRenderer::~OpenGLResponseRenderer()
+{
+    cancelPendingUpdate();
+    stopTimer();
+    detach();
+}
+
+void OpenGLResponseRenderer::attach()
+{
+    if (attached || failed.load())
+        return;
+
+    context.attachTo(target);
+    attached = true;
+
+    // Nothing tells us when a context never arrives, so watch for the first frame
+    showingMilliseconds = 0;
+    startTimer(contextCheckMilliseconds);
+}
+
+void OpenGLResponseRenderer::detach()
+{
+    stopTimer();
+
+    if (!attached)
+        return;
+
+    // Blocks until the GL thread has called openGLContextClosing
+    context.detach();
+    attached = false;
+}
+
+void OpenGLResponseRenderer::setBackground(const juce::Image& image, float imageScale, juce::Rectangle<float> newBorder)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pendingBackground = image;
+        pendingBackgroundScale = imageScale;
+        pendingBorder = newBorder;
+        pendingBounds = target.getLocalBounds();
+    }
+
+    if (attached)
+        context.triggerRepaint();
+}
+
+void OpenGLResponseRenderer::setCurves(const std::vector<Curve>& curves)
+{
+    std::vector<Vertex> newVertices;
+    std::vector<Range> newRanges;
+
+    for (const auto& curve : curves)
+    {
+        Range range{ static_cast<int>(newVertices.size()), 0, curve.colour, curve.thickness };
+
+        // One pixel of fringe on each side for the fade
+        auto halfWidth = curve.thickness * 0.5f + 1.f;
+
+        for (juce::PathFlatteningIterator it(*curve.path); it.next();)
+        {
+            juce::Point<float> start(it.x1, it.y1), end(it.x2, it.y2);
+            auto direction = end - start;
+            auto length = direction.getDistanceFromOrigin();
+
+            if (length <= 0.f)
+                continue;
+
+            auto normal = juce::Point<float>(-direction.y, direction.x) * (halfWidth / length);
+
+            const Vertex quad[] =
+            {
+                { start.x + normal.x, start.y + normal.y,  1.f },
+                { start.x - normal.x, start.y - normal.y, -1.f },
+                { end.x + normal.x,   end.y + normal.y,    1.f },
+                { end.x + normal.x,   end.y + normal.y,    1.f },
+                { start.x - normal.x, start.y - normal.y, -1.f },
+                { end.x - normal.x,   end.y - normal.y,   -1.f },
+            };
+
+            newVertices.insert(newVertices.end(), std::begin(quad), std::end(quad));
+        }
+
+        range.count = static_cast<int>(newVertices.size()) - range.first;
+
+        if (range.count > 0)
+            newRanges.push_back(range);
+    }
+
+    {
+        const juce::ScopedLock sl(lock);
+        pendingVertices.swap(newVertices);
+        pendingRanges.swap(newRanges);
+        pendingBounds = target.getLocalBounds();
+        curvesChanged = true;
+    }
+
+    if (attached)
+        context.triggerRepaint();
+}
+
+void OpenGLResponseRenderer::newOpenGLContextCreated()
+{
+    shader = std::make_unique<juce::OpenGLShaderProgram>(context);
+
+    if (!shader->addVertexShader(juce::OpenGLHelpers::translateVertexShaderToV3(vertexShaderSource))
+        || !shader->addFragmentShader(juce::OpenGLHelpers::translateFragmentShaderToV3(fragmentShaderSource))
+        || !shader->link())
+    {
+        DBG("OpenGLResponseRenderer: " << shader->getLastError());
+        shader.reset();
+
+        failed.store(true);
+        triggerAsyncUpdate();
+        return;
+    }
+
+    viewportSizeUniform = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*shader, "viewportSize");
+    colourUniform = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*shader, "colour");
+    halfWidthUniform = std::make_unique<juce::OpenGLShaderProgram::Uniform>(*shader, "halfWidth");
+
+    positionAttribute = juce::OpenGLShaderProgram::Attribute(*shader, "position").attributeID;
+    edgeAttribute = juce::OpenGLShaderProgram::Attribute(*shader, "edge").attributeID;
+
+    context.extensions.glGenBuffers(1, &vertexBuffer);
+}
+
+void OpenGLResponseRenderer::renderOpenGL()
+{
+    jassert(juce::OpenGLHelpers::isContextActive());
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        background = pendingBackground;
+        backgroundScale = pendingBackgroundScale;
+        border = pendingBorder;
+
+        // The component's size as the message thread last saw it
+        bounds = pendingBounds;
+
+        // The message thread builds a fresh set each time, so just take it
+        if (curvesChanged)
+        {
+            vertices.swap(pendingVertices);
+            ranges.swap(pendingRanges);
+            curvesChanged = false;
+        }
+    }
+
+    auto scale = static_cast<float>(context.getRenderingScale());
+    auto width = juce::roundToInt(scale * bounds.getWidth());
+    auto height = juce::roundToInt(scale * bounds.getHeight());
+
+    juce::OpenGLHelpers::clear(juce::Colours::black);
+
+    if (background.isValid())
+    {
+        // Images drawn through the GL context are uploaded once and kept as textures
+        std::unique_ptr<juce::LowLevelGraphicsContext> glGraphics(createOpenGLGraphicsContext(context, width, height));
+
+        if (glGraphics != nullptr)
+        {
+            juce::Graphics g(*glGraphics);
+            g.addTransform(juce::AffineTransform::scale(scale));
+            g.drawImageTransformed(background, juce::AffineTransform::scale(1.f / backgroundScale));
+
+            g.setColour(juce::Colours::orange);
+            g.drawRoundedRectangle(border, 4.f, 1.f);
+        }
+    }
+
+    glViewport(0, 0, width, height);
+    drawCurves(scale);
+
+    frameRendered.store(true);
+}
+
+void OpenGLResponseRenderer::drawCurves(float scale)
+{
+    if (shader == nullptr || vertices.empty())
+        return;
+
+    auto& ext = context.extensions;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    shader->use();
+    viewportSizeUniform->set(static_cast<GLfloat>(bounds.getWidth()), static_cast<GLfloat>(bounds.getHeight()));
+
+    ext.glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    ext.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)),
+        vertices.data(), GL_STREAM_DRAW);
+
+    ext.glVertexAttribPointer(static_cast<GLuint>(positionAttribute), 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+    ext.glEnableVertexAttribArray(static_cast<GLuint>(positionAttribute));
+
+    ext.glVertexAttribPointer(static_cast<GLuint>(edgeAttribute), 1, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+        reinterpret_cast<GLvoid*>(2 * sizeof(float)));
+    ext.glEnableVertexAttribArray(static_cast<GLuint>(edgeAttribute));
+
+    for (const auto& range : ranges)
+    {
+        // Premultiplied, to match the blend function
+        auto c = range.colour;
+        auto alpha = c.getFloatAlpha();
+        colourUniform->set(c.getFloatRed() * alpha, c.getFloatGreen() * alpha, c.getFloatBlue() * alpha, alpha);
+        halfWidthUniform->set((range.thickness * 0.5f + 1.f) * scale);
+
+        glDrawArrays(GL_TRIANGLES, range.first, range.count);
+    }
+
+    ext.glDisableVertexAttribArray(static_cast<GLuint>(positionAttribute));
+    ext.glDisableVertexAttribArray(static_cast<GLuint>(edgeAttribute));
+    ext.glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OpenGLResponseRenderer::openGLContextClosing()
+{
+    if (vertexBuffer != 0)
+        context.extensions.glDeleteBuffers(1, &vertexBuffer);
+
+    vertexBuffer = 0;
+
+    viewportSizeUniform.reset();
+    colourUniform.reset();
+    halfWidthUniform.reset();
+    shader.reset();
+
+    background = {};
+}
+
+void OpenGLResponseRenderer::handleAsyncUpdate()
+{
+    // The shaders didn't build on this machine, or no context came up
+    detach();
+
+    if (onFallback)
+        onFallback();
+}
+
+void OpenGLResponseRenderer::timerCallback()
+{
+    if (frameRendered.load())
+    {
+        stopTimer();
+        return;
+    }
+
+    if (target.isShowing())
+        showingMilliseconds += contextCheckMilliseconds;
+
+    if (showingMilliseconds >= contextTimeoutMilliseconds)
+    {
+        stopTimer();
+        failed.store(true);
+        handleAsyncUpdate();
+    }
+}
+
+#endif
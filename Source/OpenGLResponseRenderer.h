@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    OpenGLResponseRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Each editor using the renderer gets its own OpenGLContext and render thread,
+// so editors only turn it on when a project asks for it. juce::Graphics is the default.
+#ifndef SIMPLEEQ_USE_OPENGL
+ #define SIMPLEEQ_USE_OPENGL 0
+#endif
+
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+
+#include <vector>
+
+/**
+    Draws the response curve display with OpenGL instead of the software renderer.
+
+    The grid image goes through JUCE's GL graphics context, which keeps it as a
+    cached texture. The curves are triangulated on the message thread into
+    quads whose edges fade out in the fragment shader, so the GPU does the
+    anti-aliasing, and are uploaded as one vertex buffer per frame.
+
+    If the shaders can't be built, or no frame has been rendered a while after the
+    component started showing (no GL driver, a remote session, a headless VM),
+    the context is detached again and onFallback is called, so the component
+    can go back to painting with juce::Graphics.
+*/
+class OpenGLResponseRenderer : private juce::OpenGLRenderer,
+    private juce::AsyncUpdater,
+    private juce::Timer
+{
+public:
+    struct Curve
+    {
+        const juce::Path* path;
+        juce::Colour colour;
+        float thickness;
+    };
+
+    explicit OpenGLResponseRenderer(juce::Component& component);
+    ~OpenGLResponseRenderer() override;
+
+    // Message thread
+    void attach();
+    void detach();
+    bool isAttached() const { return attached; }
+
+    // The grid, at the given scale, and the frame drawn on top of it
+    void setBackground(const juce::Image& image, float imageScale, juce::Rectangle<float> border);
+
+    // Replaces everything drawn over the background. Paths must be made of lines.
+    void setCurves(const std::vector<Curve>& curves);
+
+    std::function<void()> onFallback;
+
+private:
+    struct Vertex
+    {
+        float x, y, edge;
+    };
+
+    struct Range
+    {
+        int first, count;
+        juce::Colour colour;
+        float thickness;
+    };
+
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+
+    void drawCurves(float scale);
+
+    juce::Component& target;
+    juce::OpenGLContext context;
+    bool attached{ false };
+
+    // How long the target may be showing without a frame before we give up.
+    // Only counted while it is showing, as there is no context before that.
+    static constexpr int contextTimeoutMilliseconds = 2000;
+    static constexpr int contextCheckMilliseconds = 250;
+    int showingMilliseconds{ 0 };
+    std::atomic<bool> frameRendered{ false };
+
+    // Written on the message thread, swapped out by the GL thread
+    juce::CriticalSection lock;
+    juce::Image pendingBackground;
+    float pendingBackgroundScale{ 1.f };
+    juce::Rectangle<float> pendingBorder;
+    juce::Rectangle<int> pendingBounds;
+    std::vector<Vertex> pendingVertices;
+    std::vector<Range> pendingRanges;
+    bool curvesChanged{ false };
+
+    // GL thread only
+    juce::Image background;
+    float backgroundScale{ 1.f };
+    juce::Rectangle<float> border;
+    juce::Rectangle<int> bounds;
+    std::vector<Vertex> vertices;
+    std::vector<Range> ranges;
+
+    std::unique_ptr<juce::OpenGLShaderProgram> shader;
+    std::unique_ptr<juce::OpenGLShaderProgram::Uniform> viewportSizeUniform, colourUniform, halfWidthUniform;
+    GLint positionAttribute{ -1 }, edgeAttribute{ -1 };
+    GLuint vertexBuffer{ 0 };
+    std::atomic<bool> failed{ false };
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    Parameters.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+
+#include <array>
+#include <atomic>
+
+// Parameter IDs, shared by createParameterLayout, the bindings below and the
+// editor's attachments. They double as the parameter names.
+namespace ParamIDs
+{
+    constexpr const char* lowCutFreq = "LowCut Freq";
+    constexpr const char* highCutFreq = "HighCut Freq";
+    constexpr const char* peakFreq = "Peak Freq";
+    constexpr const char* peakGain = "Peak Gain";
+    constexpr const char* peakQuality = "Peak Quality";
+    constexpr const char* lowCutSlope = "LowCut Slope";
+    constexpr const char* highCutSlope = "HighCut Slope";
+    constexpr const char* oversampling = "Oversampling";
+    constexpr const char* smoothing = "Smoothing";
+    constexpr const char* linearPhase = "Linear Phase";
+    constexpr const char* peakType = "Peak Type";
+
+    struct BandIDs
+    {
+        const char* type;
+        const char* freq;
+        const char* gain;
+        const char* quality;
+    };
+
+    // One entry per parametric band. Band 1 keeps the IDs of the original peak
+    // band, so existing sessions and automation still find it.
+    constexpr BandIDs bands[numParametricBands] =
+    {
+        { peakType,      peakFreq,      peakGain,      peakQuality },
+        { "Band 2 Type", "Band 2 Freq", "Band 2 Gain", "Band 2 Quality" },
+        { "Band 3 Type", "Band 3 Freq", "Band 3 Gain", "Band 3 Quality" },
+        { "Band 4 Type", "Band 4 Freq", "Band 4 Gain", "Band 4 Quality" },
+        { "Band 5 Type", "Band 5 Freq", "Band 5 Gain", "Band 5 Quality" },
+        { "Band 6 Type", "Band 6 Freq", "Band 6 Gain", "Band 6 Quality" },
+        { "Band 7 Type", "Band 7 Freq", "Band 7 Gain", "Band 7 Quality" },
+        { "Band 8 Type", "Band 8 Freq", "Band 8 Gain", "Band 8 Quality" }
+    };
+}
+
+/**
+    The raw values of the parameters, looked up by ID once at construction.
+    Reading the settings is then just a relaxed load per parameter, which is
+    cheap enough for every audio block and every UI update.
+*/
+struct ParameterBindings
+{
+    explicit ParameterBindings(juce::AudioProcessorValueTreeState& apvts) :
+        lowCutFreq(resolve(apvts, ParamIDs::lowCutFreq)),
+        highCutFreq(resolve(apvts, ParamIDs::highCutFreq)),
+        lowCutSlope(resolve(apvts, ParamIDs::lowCutSlope)),
+        highCutSlope(resolve(apvts, ParamIDs::highCutSlope)),
+        oversampling(resolve(apvts, ParamIDs::oversampling)),
+        smoothing(resolve(apvts, ParamIDs::smoothing)),
+        linearPhase(resolve(apvts, ParamIDs::linearPhase))
+    {
+        for (int i = 0; i < numParametricBands; ++i)
+        {
+            const auto& ids = ParamIDs::bands[i];
+            bands[static_cast<size_t>(i)] = { resolve(apvts, ids.type), resolve(apvts, ids.freq),
+                resolve(apvts, ids.gain), resolve(apvts, ids.quality) };
+        }
+    }
+
+    ChainSettings getChainSettings() const noexcept
+    {
+        ChainSettings settings;
+
+        settings.lowCutFreq = lowCutFreq->load(std::memory_order_relaxed);
+        settings.highCutFreq = highCutFreq->load(std::memory_order_relaxed);
+        settings.lowCutSlope = static_cast<Slope>(lowCutSlope->load(std::memory_order_relaxed));
+        settings.highCutSlope = static_cast<Slope>(highCutSlope->load(std::memory_order_relaxed));
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            auto& band = settings.bands[i];
+
+            band.type = static_cast<BandType>(bands[i].type->load(std::memory_order_relaxed));
+            band.freq = bands[i].freq->load(std::memory_order_relaxed);
+            band.gainInDecibels = bands[i].gain->load(std::memory_order_relaxed);
+            band.quality = bands[i].quality->load(std::memory_order_relaxed);
+        }
+
+        return settings;
+    }
+
+    // 1, 2 or 4
+    int getOversamplingFactor() const noexcept
+    {
+        auto index = static_cast<int>(oversampling->load(std::memory_order_relaxed));
+        return 1 << juce::jlimit(0, 2, index);
+    }
+
+    // Index into the choices of the "Smoothing" parameter
+    int getSmoothingIndex() const noexcept
+    {
+        return static_cast<int>(smoothing->load(std::memory_order_relaxed));
+    }
+
+    bool isLinearPhase() const noexcept
+    {
+        return linearPhase->load(std::memory_order_relaxed) >= 0.5f;
+    }
+
+private:
+    static std::atomic<float>* resolve(juce::AudioProcessorValueTreeState& apvts, const char* parameterID)
+    {
+        auto* value = apvts.getRawParameterValue(parameterID);
+        jassert(value != nullptr);
+        return value;
+    }
+
+    std::atomic<float>* lowCutFreq;
+    std::atomic<float>* highCutFreq;
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* oversampling;
+    std::atomic<float>* smoothing;
+    std::atomic<float>* linearPhase;
+
+    struct BandValues
+    {
+        std::atomic<float>* type;
+        std::atomic<float>* freq;
+        std::atomic<float>* gain;
+        std::atomic<float>* quality;
+    };
+
+    std::array<BandValues, numParametricBands> bands;
+};
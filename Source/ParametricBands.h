@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    ParametricBands.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+
+/**
+    Every parametric band of a chain, one second order section each, with one
+    channel per SIMD lane.
+
+    Coefficients and state live in one contiguous array per term, indexed by
+    band. The bands that are active are listed in order in a compacted table,
+    and the Kernel only gathers and runs those, so a band that is off costs
+    nothing per sample. An inactive band's state stays where it was.
+*/
+template<typename SampleType>
+class ParametricBands
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int maxNumBands = numParametricBands;
+
+    ParametricBands()
+    {
+        // Start out as pass-through sections, with none of them active
+        for (int band = 0; band < maxNumBands; ++band)
+            setCoefficients(band, {});
+
+        reset();
+    }
+
+    void setCoefficients(int band, const BiquadCoefficients& section)
+    {
+        jassert(band >= 0 && band < maxNumBands);
+
+        b0[band] = Vec::expand(static_cast<SampleType>(section.b0));
+        b1[band] = Vec::expand(static_cast<SampleType>(section.b1));
+        b2[band] = Vec::expand(static_cast<SampleType>(section.b2));
+        a1[band] = Vec::expand(static_cast<SampleType>(section.a1));
+        a2[band] = Vec::expand(static_cast<SampleType>(section.a2));
+    }
+
+    // Bit n set means band n runs in the Kernel
+    void setActiveBands(juce::uint32 mask)
+    {
+        numActiveBands = 0;
+
+        for (int band = 0; band < maxNumBands; ++band)
+            if ((mask & (1u << band)) != 0)
+                activeBands[numActiveBands++] = band;
+    }
+
+    int getNumActiveBands() const noexcept { return numActiveBands; }
+
+    // The largest state value of any active band and lane, to tell when a tail
+    // has died away. Inactive bands are frozen, so they don't count.
+    SampleType getStateMagnitude() const noexcept
+    {
+        auto magnitude = Vec::expand(SampleType(0));
+
+        for (int k = 0; k < numActiveBands; ++k)
+        {
+            auto band = activeBands[k];
+            magnitude = Vec::max(magnitude, Vec::max(Vec::abs(s1[band]), Vec::abs(s2[band])));
+        }
+
+        SampleType result = 0;
+
+        for (size_t lane = 0; lane < Vec::size(); ++lane)
+            result = juce::jmax(result, magnitude.get(lane));
+
+        return result;
+    }
+
+    void reset()
+    {
+        for (int band = 0; band < maxNumBands; ++band)
+            reset(band);
+    }
+
+    void reset(int band)
+    {
+        s1[band] = Vec::expand(SampleType(0));
+        s2[band] = Vec::expand(SampleType(0));
+    }
+
+    /** The active bands with their coefficients and state copied into locals,
+        as SOSCascade::Kernel does. Unlike the cut sections, the number of
+        bands is only known at run time: the loop just walks the compacted
+        table, so the chain doesn't need a variant per band count.
+        Call store() when done so the state carries over to the next block.
+    */
+    struct Kernel
+    {
+        explicit Kernel(const ParametricBands& bands) noexcept : numBands(bands.numActiveBands)
+        {
+            for (int k = 0; k < numBands; ++k)
+            {
+                auto band = bands.activeBands[k];
+
+                c0[k] = bands.b0[band]; c1[k] = bands.b1[band]; c2[k] = bands.b2[band];
+                d1[k] = bands.a1[band]; d2[k] = bands.a2[band];
+                z1[k] = bands.s1[band]; z2[k] = bands.s2[band];
+            }
+        }
+
+        Vec process(Vec x) noexcept
+        {
+            for (int k = 0; k < numBands; ++k)
+            {
+                auto y = c0[k] * x + z1[k];
+                z1[k] = c1[k] * x - d1[k] * y + z2[k];
+                z2[k] = c2[k] * x - d2[k] * y;
+                x = y;
+            }
+
+            return x;
+        }
+
+        void store(ParametricBands& bands) const noexcept
+        {
+            for (int k = 0; k < numBands; ++k)
+            {
+                auto band = bands.activeBands[k];
+
+                bands.s1[band] = z1[k];
+                bands.s2[band] = z2[k];
+            }
+        }
+
+        int numBands;
+        std::array<Vec, maxNumBands> c0, c1, c2, d1, d2;
+        std::array<Vec, maxNumBands> z1, z2;
+    };
+
+    // One frame through one band, for the rare paths that need to mix per sample
+    Vec processSample(int band, Vec x) noexcept
+    {
+        auto y = b0[band] * x + s1[band];
+        s1[band] = b1[band] * x - a1[band] * y + s2[band];
+        s2[band] = b2[band] * x - a2[band] * y;
+
+        return y;
+    }
+
+private:
+    std::array<Vec, maxNumBands> b0, b1, b2, a1, a2;
+    std::array<Vec, maxNumBands> s1, s2;
+
+    std::array<int, maxNumBands> activeBands{};
+    int numActiveBands{ 0 };
+};
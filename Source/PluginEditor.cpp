@@ -17,74 +17,139 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g,
 {
 	using namespace juce;
 
+	ignoreUnused(slider);
+
 	auto bounds = Rectangle<float>(x, y, width, height);
 
+	drawRotarySliderBody(g, bounds);
+
+	jassert(rotaryStartAngle < rotaryEndAngle);
+
+	auto sliderAngleRad = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+	auto center = bounds.getCentre();
+
+	g.fillPath(createRotarySliderPointer(bounds, bounds.getHeight() * 0.25f),
+		AffineTransform().rotated(sliderAngleRad, center.getX(), center.getY()));
+}
+
+void LookAndFeel::drawRotarySliderBody(juce::Graphics& g, juce::Rectangle<float> bounds)
+{
+	using namespace juce;
+
 	g.setColour(Colour(97u, 18u, 167u));
 	g.fillEllipse(bounds);
 
 	g.setColour(Colour(255u, 154u, 1u));
 	g.drawEllipse(bounds, 1.f);
+}
 
-	if (auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider))
-	{
-		auto center = bounds.getCentre();
-
-		Path p;
-		Rectangle<float> r;
-		r.setLeft(center.getX() - 2);
-		r.setRight(center.getX() + 2);
-		r.setTop(bounds.getY());
-		r.setBottom(center.getY() - rswl->getTextHeight() * 1.5);
+juce::Path LookAndFeel::createRotarySliderPointer(juce::Rectangle<float> bounds, float innerRadius)
+{
+	using namespace juce;
 
-		p.addRoundedRectangle(r, 2.f);
+	auto center = bounds.getCentre();
 
-		jassert(rotaryStartAngle < rotaryEndAngle);
+	Path p;
+	Rectangle<float> r;
+	r.setLeft(center.getX() - 2);
+	r.setRight(center.getX() + 2);
+	r.setTop(bounds.getY());
+	r.setBottom(center.getY() - innerRadius);
 
-		auto sliderAngleRad = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
-		p.applyTransform(AffineTransform().rotated(sliderAngleRad, center.getX(), center.getY()));
+	p.addRoundedRectangle(r, 2.f);
 
-		g.fillPath(p);
+	return p;
+}
 
-		g.setFont(rswl->getTextHeight());
-		auto text = rswl->getDisplayString();
-		auto strWidth = g.getCurrentFont().getStringWidth(text);
+//================================================================================
+juce::Image EditorResources::findBackground(juce::Rectangle<int> bounds, float scale) const
+{
+	for (const auto& cached : backgrounds)
+		if (cached.image.isValid() && cached.bounds == bounds && cached.scale == scale)
+			return cached.image;
 
-		r.setSize(strWidth + 4, rswl->getTextHeight() + 2);
-		r.setCentre(bounds.getCentre());
+	return {};
+}
 
-		g.setColour(Colours::black);
-		g.fillRect(r);
+void EditorResources::addBackground(juce::Rectangle<int> bounds, float scale, const juce::Image& image)
+{
+	// Oldest first: the sizes in use right now are the ones that were just added
+	auto& cached = backgrounds[nextBackground];
+	nextBackground = (nextBackground + 1) % backgrounds.size();
 
-		g.setColour(Colours::white);
-		g.drawFittedText(text, r.toNearestInt(), juce::Justification::centred, 1);
-	}
+	cached.bounds = bounds;
+	cached.scale = scale;
+	cached.image = image;
 }
 
 //================================================================================
+static const float rotaryStartAngle = juce::degreesToRadians(180.f + 45.f);
+static const float rotaryEndAngle = juce::degreesToRadians(180.f - 45.f) + juce::MathConstants<float>::twoPi;
+
 void RotarySliderWithLabels::paint(juce::Graphics& g)
 {
 	using namespace juce;
 
-	auto startAngle = degreesToRadians(180.f + 45.f);
-	auto endAngle = degreesToRadians(180.f - 45.f) + MathConstants<float>::twoPi;
+	if (!staticLayerValid || Component::getApproximateScaleFactorForComponent(this) != staticLayerScale)
+		updateStaticLayer();
+
+	g.drawImageTransformed(staticLayer, AffineTransform::scale(1.f / staticLayerScale));
 
 	auto range = getRange();
+	auto sliderPos = jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0);
+	auto sliderAngleRad = jmap(float(sliderPos), 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+	auto center = getSliderBounds().toFloat().getCentre();
+
+	g.setColour(Colour(255u, 154u, 1u));
+	g.fillPath(pointer, AffineTransform().rotated(sliderAngleRad, center.getX(), center.getY()));
+
+	if (getValue() != displayedValue)
+		updateDisplayString();
+
+	g.setColour(Colours::black);
+	g.fillRect(displayStringBounds);
+
+	g.setColour(Colours::white);
+	g.setFont(resources->labelFont);
+	g.drawFittedText(displayString, displayStringBounds.toNearestInt(), juce::Justification::centred, 1);
+}
+
+void RotarySliderWithLabels::resized()
+{
+	auto sliderBounds = getSliderBounds().toFloat();
+
+	pointer = resources->lookAndFeel.createRotarySliderPointer(sliderBounds, getTextHeight() * 1.5f);
+
+	// Both are rebuilt by the next paint, so a window that is never shown
+	// never draws its knobs
+	staticLayerValid = false;
+	displayedValue = std::numeric_limits<double>::quiet_NaN();
+}
+
+void RotarySliderWithLabels::updateStaticLayer()
+{
+	using namespace juce;
+
+	staticLayerScale = Component::getApproximateScaleFactorForComponent(this);
+	staticLayerValid = true;
+
+	staticLayer = Image(Image::PixelFormat::ARGB,
+		jmax(1, roundToInt(getWidth() * staticLayerScale)),
+		jmax(1, roundToInt(getHeight() * staticLayerScale)),
+		true);
+
+	Graphics g(staticLayer);
+	g.addTransform(AffineTransform::scale(staticLayerScale));
 
 	auto sliderBounds = getSliderBounds();
 
-	getLookAndFeel().drawRotarySlider(g, 
-		sliderBounds.getX(), 
-		sliderBounds.getY(), 
-		sliderBounds.getWidth(),
-		sliderBounds.getHeight(),
-		jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0), 
-		startAngle, endAngle, *this);
+	resources->lookAndFeel.drawRotarySliderBody(g, sliderBounds.toFloat());
 
 	auto center = sliderBounds.toFloat().getCentre();
 	auto radius = sliderBounds.getWidth() * 0.5f;
 
 	g.setColour(Colour(0u, 172u, 1u));
-	g.setFont(getTextHeight());
+	g.setFont(resources->labelFont);
 
 	auto numChoices = labels.size();
 	for (int i = 0; i < numChoices; ++i)
@@ -93,7 +158,7 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
 		jassert(0.f <= pos);
 		jassert(1.f >= pos);
 
-		auto ang = jmap(pos, 0.f, 1.f, startAngle, endAngle);
+		auto ang = jmap(pos, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
 
 		auto c = center.getPointOnCircumference(radius + getTextHeight() * 0.5f + 1, ang);
 
@@ -108,6 +173,17 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
 	}
 }
 
+void RotarySliderWithLabels::updateDisplayString()
+{
+	displayedValue = getValue();
+	displayString = getDisplayString();
+
+	auto strWidth = resources->labelFont.getStringWidthFloat(displayString);
+
+	displayStringBounds.setSize(strWidth + 4, getTextHeight() + 2);
+	displayStringBounds.setCentre(getSliderBounds().toFloat().getCentre());
+}
+
 juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
 {
 	auto bounds = getLocalBounds();
@@ -126,13 +202,13 @@ juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
 
 juce::String RotarySliderWithLabels::getDisplayString() const
 {
-	if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
+	if (choiceParam != nullptr)
 		return choiceParam->getCurrentChoiceName();
 
 	juce::String str;
 	bool addK = false;
 
-	if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
+	if (floatParam != nullptr)
 	{
 		float val = getValue();
 
@@ -164,109 +240,316 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 //===============================================================================
 ResponseCurveComponent::ResponseCurveComponent(SimpleEQAudioProcessor& p) : audioProcessor(p)
 {
-	const auto& params = audioProcessor.getParameters();
-	for (auto param : params)
+	// Only the ones that move the curve: the rest can't change what we draw
+	for (auto* id : { ParamIDs::lowCutFreq, ParamIDs::highCutFreq, ParamIDs::lowCutSlope, ParamIDs::highCutSlope,
+		ParamIDs::oversampling })
 	{
-		param->addListener(this);
+		curveParameters.push_back(audioProcessor.apvts.getParameter(id));
 	}
 
-	updateChain();
-
-	startTimerHz(60);
+	for (const auto& ids : ParamIDs::bands)
+		for (auto* id : { ids.type, ids.freq, ids.gain, ids.quality })
+			curveParameters.push_back(audioProcessor.apvts.getParameter(id));
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
-	const auto& params = audioProcessor.getParameters();
-	for (auto param : params)
+	if (active)
+	{
+		active = false;
+
+		for (auto* param : curveParameters)
+			param->removeListener(this);
+
+		audioProcessor.analyzer.setEnabled(false);
+		audioProcessor.analyzer.removeChangeListener(this);
+		audioProcessor.getCoefficientEngine().removeChangeListener(this);
+	}
+
+	cancelPendingUpdate();
+}
+
+void ResponseCurveComponent::updateActive()
+{
+	auto shouldBeActive = isShowing();
+
+	if (shouldBeActive == active)
+		return;
+
+	active = shouldBeActive;
+
+	if (active)
+	{
+		for (auto* param : curveParameters)
+			param->addListener(this);
+
+		audioProcessor.analyzer.addChangeListener(this);
+		audioProcessor.analyzer.setEnabled(true);
+		audioProcessor.getCoefficientEngine().addChangeListener(this);
+
+		// Whatever was designed while we were away
+		layoutValid = false;
+		startFrames();
+	}
+	else
 	{
-		param->removeListener(this);
+		for (auto* param : curveParameters)
+			param->removeListener(this);
+
+		audioProcessor.analyzer.setEnabled(false);
+		audioProcessor.analyzer.removeChangeListener(this);
+		audioProcessor.getCoefficientEngine().removeChangeListener(this);
 	}
 }
 
+void ResponseCurveComponent::ensureLayout()
+{
+	if (layoutValid)
+		return;
+
+	layoutValid = true;
+
+	// Take the newest set now, so the first frame doesn't draw a stale one
+	audioProcessor.getCoefficientEngine().acquireSnapshot();
+
+	updateBackground();
+	updateResponseCache();
+	updateResponsePath();
+	updateSpectrumPaths();
+	updateRenderer();
+}
+
 void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
 {
+	juce::ignoreUnused(parameterIndex, newValue);
+
 	parameterChanged.set(true);
+
+	// Posting a message can block, so only the message thread starts the
+	// frames from here. From any other thread, the engine's change message
+	// starts them once the new coefficients are published.
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		startFrames();
+}
+
+void ResponseCurveComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+	juce::ignoreUnused(source);
+	startFrames();
+}
+
+void ResponseCurveComponent::handleAsyncUpdate()
+{
+	if (parameterChanged.get())
+		startFrames();
+	else if (idleFrames > maxIdleFrames || !isShowing())
+		vBlankAttachment.reset();
+
+	updateActive();
 }
 
-void ResponseCurveComponent::timerCallback()
+void ResponseCurveComponent::visibilityChanged()
 {
+	updateActive();
+	startFrames();
+}
+
+void ResponseCurveComponent::parentHierarchyChanged()
+{
+	updateActive();
+	startFrames();
+}
+
+void ResponseCurveComponent::startFrames()
+{
+	idleFrames = 0;
+
+	if (isShowing() && vBlankAttachment == nullptr)
+		vBlankAttachment = std::make_unique<juce::VBlankAttachment>(this, [this] { onVBlank(); });
+}
+
+void ResponseCurveComponent::onVBlank()
+{
+	if (!isShowing())
+	{
+		// Detaching from inside the callback isn't safe, so leave that to handleAsyncUpdate
+		triggerAsyncUpdate();
+		return;
+	}
+
+	auto now = juce::Time::getMillisecondCounterHiRes();
+
+	if (maximumFrameRate > 0.0 && now - lastFrameTime < 1000.0 / maximumFrameRate)
+		return;
+
+	bool changed = !layoutValid;
+	ensureLayout();
+
+	// A parameter change only keeps the frames going: the curve follows the
+	// coefficients the engine publishes for it, a moment later
 	if (parameterChanged.compareAndSetBool(false, true))
+		idleFrames = 0;
+
+	if (audioProcessor.getCoefficientEngine().acquireSnapshot())
+	{
+		updateResponseCache();
+		updateResponsePath();
+		changed = true;
+	}
+
+	if (audioProcessor.analyzer.acquire())
+	{
+		updateSpectrumPaths();
+		changed = true;
+	}
+
+	if (changed)
 	{
-		// update the MonoChain
-		updateChain();
+		lastFrameTime = now;
+		idleFrames = 0;
 
 		// signal a repaint
 		repaint();
+		updateRenderer();
+	}
+	else if (++idleFrames == maxIdleFrames + 1)
+	{
+		triggerAsyncUpdate();
 	}
 }
 
-void ResponseCurveComponent::updateChain()
+void ResponseCurveComponent::updateSpectrumPaths()
 {
-	auto chainSettings = getChainSettings(audioProcessor.apvts);
+	using namespace juce;
+
+	const auto& frame = audioProcessor.analyzer.getFrame();
 
-	auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-	updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+	auto analysisArea = getAnalysisArea().toFloat();
+	auto left = analysisArea.getX();
+	auto width = analysisArea.getWidth();
+	auto top = analysisArea.getY();
+	auto bottom = analysisArea.getBottom();
 
-	auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-	auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
+	auto binWidth = frame.sampleRate / double(SpectrumAnalyzer::fftSize);
 
-	updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-	updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+	for (size_t spectrum = 0; spectrum < spectrumPaths.size(); ++spectrum)
+	{
+		auto& path = spectrumPaths[spectrum];
+		const auto& magnitudes = frame.magnitudesInDecibels[spectrum];
+
+		path.clear();
+		path.preallocateSpace(3 * SpectrumAnalyzer::numBins);
+
+		for (int bin = 1; bin < SpectrumAnalyzer::numBins; ++bin)
+		{
+			auto freq = bin * binWidth;
+
+			if (freq < 20.0)
+				continue;
+
+			if (freq > 20000.0)
+				break;
+
+			auto x = left + width * mapFromLog10(float(freq), 20.f, 20000.f);
+			auto y = jmap(jlimit(-48.f, 0.f, magnitudes[bin]), -48.f, 0.f, bottom, top);
+
+			if (path.isEmpty())
+				path.startNewSubPath(x, y);
+			else
+				path.lineTo(x, y);
+		}
+	}
 }
 
-void ResponseCurveComponent::paint(juce::Graphics& g)
+void ResponseCurveComponent::updateResponseCache()
 {
 	using namespace juce;
-	// (Our component is opaque, so we must completely fill the background with a solid colour)
-	g.fillAll(Colours::black);
 
-	g.drawImage(background, getLocalBounds().toFloat());
+	auto w = getAnalysisArea().getWidth();
 
-	auto responseArea = getAnalysisArea(); //getLocalBounds();
+	const auto& snapshot = audioProcessor.getCoefficientEngine().getSnapshot();
+	const auto& coefficients = snapshot.coefficients;
+	auto sampleRate = snapshot.sampleRate;
 
-	auto w = responseArea.getWidth();
+	// Nothing has been designed yet
+	if (w <= 0 || sampleRate <= 0.0)
+		return;
 
-	auto& lowCut = monoChain.get<ChainPositions::LowCut>();
-	auto& highCut = monoChain.get<ChainPositions::HighCut>();
-	auto& peak = monoChain.get<ChainPositions::Peak>();
+	bool layoutChanged = w != cachedWidth || sampleRate != cachedSampleRate;
 
-	auto sampleRate = audioProcessor.getSampleRate();
+	bool lowCutChanged = layoutChanged || snapshot.lowCutVersion != cachedLowCutVersion;
+	bool highCutChanged = layoutChanged || snapshot.highCutVersion != cachedHighCutVersion;
+
+	if (layoutChanged)
+	{
+		columnFrequencies.resize(w);
+
+		for (int i = 0; i < w; ++i)
+			columnFrequencies[i] = mapToLog10(double(i) / double(w), 20.0, 20000.0);
 
-	std::vector<double> mags;
+		responseEvaluator.prepare(columnFrequencies.data(), w, sampleRate);
 
-	mags.resize(w);
+		lowCutMagnitudes.resize(w);
+		highCutMagnitudes.resize(w);
+		responseMagnitudes.resize(w);
+
+		for (auto& magnitudes : bandMagnitudes)
+			magnitudes.resize(w);
+	}
+
+	// Bypassed stages evaluate as 0 sections, i.e. 0 dB
+	auto numCutSections = [](const CutCoefficients& cut)
+	{
+		return cut.bypassed ? 0 : static_cast<int>(cut.slope) + 1;
+	};
+
+	if (lowCutChanged)
+		responseEvaluator.computeResponse(coefficients.lowCut.sections.data(),
+			numCutSections(coefficients.lowCut), lowCutMagnitudes.data());
+
+	if (highCutChanged)
+		responseEvaluator.computeResponse(coefficients.highCut.sections.data(),
+			numCutSections(coefficients.highCut), highCutMagnitudes.data());
 
 	for (int i = 0; i < w; ++i)
+		responseMagnitudes[i] = lowCutMagnitudes[i] + highCutMagnitudes[i];
+
+	// Bands that are off are neither evaluated nor summed
+	for (size_t band = 0; band < bandMagnitudes.size(); ++band)
 	{
-		double mag = 1.f;
-		auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-
-		if (!monoChain.isBypassed<ChainPositions::Peak>())
-			mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-		if (!lowCut.isBypassed<0>())
-			mag *= lowCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		if (!lowCut.isBypassed<1>())
-			mag *= lowCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		if (!lowCut.isBypassed<2>())
-			mag *= lowCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		if (!lowCut.isBypassed<3>())
-			mag *= lowCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-		if (!highCut.isBypassed<0>())
-			mag *= highCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		if (!highCut.isBypassed<1>())
-			mag *= highCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		if (!highCut.isBypassed<2>())
-			mag *= highCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		if (!highCut.isBypassed<3>())
-			mag *= highCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-		mags[i] = Decibels::gainToDecibels(mag);
+		const auto& bandCoefficients = coefficients.bands[band];
+
+		if (layoutChanged || snapshot.bandVersions[band] != cachedBandVersions[band])
+			responseEvaluator.computeResponse(&bandCoefficients.section,
+				bandCoefficients.bypassed ? 0 : 1, bandMagnitudes[band].data());
+
+		if (bandCoefficients.bypassed)
+			continue;
+
+		const auto& magnitudes = bandMagnitudes[band];
+
+		for (int i = 0; i < w; ++i)
+			responseMagnitudes[i] += magnitudes[i];
 	}
 
-	Path responseCurve;
+	cachedLowCutVersion = snapshot.lowCutVersion;
+	cachedHighCutVersion = snapshot.highCutVersion;
+	cachedBandVersions = snapshot.bandVersions;
+	cachedWidth = w;
+	cachedSampleRate = sampleRate;
+}
+
+void ResponseCurveComponent::updateResponsePath()
+{
+	using namespace juce;
+
+	auto responseArea = getAnalysisArea(); //getLocalBounds();
+
+	auto w = responseArea.getWidth();
+
+	const auto& mags = responseMagnitudes;
+
+	responseCurve.clear();
 
 	const double outpuMin = responseArea.getBottom();
 	const double outputMax = responseArea.getY();
@@ -275,13 +558,84 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 		return jmap(input, -24.0, 24.0, outpuMin, outputMax);
 	};
 
-	responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+	if (cachedWidth == w && !mags.empty())
+	{
+		responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
 
-	for (size_t i = 1; i < mags.size(); ++i)
+		for (size_t i = 1; i < mags.size(); ++i)
+		{
+			responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+		}
+	}
+}
+
+void ResponseCurveComponent::setOpenGLEnabled(bool shouldUseOpenGL)
+{
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+	if (!shouldUseOpenGL)
 	{
-		responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+		glRenderer.reset();
+		repaint();
+		return;
 	}
 
+	if (glRenderer != nullptr)
+		return;
+
+	glRenderer = std::make_unique<OpenGLResponseRenderer>(*this);
+
+	// No usable GL on this machine. The renderer has detached itself, so
+	// paint() takes over again.
+	glRenderer->onFallback = [this] { repaint(); };
+
+	glRenderer->attach();
+	updateRenderer();
+#else
+	juce::ignoreUnused(shouldUseOpenGL);
+#endif
+}
+
+void ResponseCurveComponent::updateRenderer()
+{
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+	if (glRenderer == nullptr || !glRenderer->isAttached())
+		return;
+
+	using namespace juce;
+
+	glRenderer->setBackground(background, backgroundScale, getRenderArea().toFloat());
+	glRenderer->setCurves({
+		{ &spectrumPaths[SpectrumAnalyzer::PreLeft], Colours::skyblue.withAlpha(0.3f), 1.f },
+		{ &spectrumPaths[SpectrumAnalyzer::PreRight], Colours::skyblue.withAlpha(0.3f), 1.f },
+		{ &spectrumPaths[SpectrumAnalyzer::PostLeft], Colours::skyblue, 1.f },
+		{ &spectrumPaths[SpectrumAnalyzer::PostRight], Colours::lightyellow, 1.f },
+		{ &responseCurve, Colours::white, 2.f }
+	});
+#endif
+}
+
+void ResponseCurveComponent::paint(juce::Graphics& g)
+{
+	using namespace juce;
+	// (Our component is opaque, so we must completely fill the background with a solid colour)
+	g.fillAll(Colours::black);
+
+	ensureLayout();
+
+	// The grid is rendered at the physical resolution, so undo the scale and blit it 1:1
+	updateBackground();
+	g.drawImageTransformed(background, AffineTransform::scale(1.f / backgroundScale));
+
+	// Input spectra dimmed behind the output spectra
+	g.setColour(Colours::skyblue.withAlpha(0.3f));
+	g.strokePath(spectrumPaths[SpectrumAnalyzer::PreLeft], PathStrokeType(1));
+	g.strokePath(spectrumPaths[SpectrumAnalyzer::PreRight], PathStrokeType(1));
+
+	g.setColour(Colours::skyblue);
+	g.strokePath(spectrumPaths[SpectrumAnalyzer::PostLeft], PathStrokeType(1));
+	g.setColour(Colours::lightyellow);
+	g.strokePath(spectrumPaths[SpectrumAnalyzer::PostRight], PathStrokeType(1));
+
 	g.setColour(Colours::orange);
 	g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
 
@@ -291,11 +645,36 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 }
 
 void ResponseCurveComponent::resized()
+{
+	layoutValid = false;
+	startFrames();
+}
+
+void ResponseCurveComponent::updateBackground()
 {
 	using namespace juce;
-	background = Image(Image::PixelFormat::RGB, getWidth(), getHeight(), true);
+
+	auto scale = Component::getApproximateScaleFactorForComponent(this);
+
+	if (background.isValid() && scale == backgroundScale && getLocalBounds() == backgroundBounds)
+		return;
+
+	backgroundScale = scale;
+	backgroundBounds = getLocalBounds();
+
+	// Another editor at the same size may have drawn it already
+	background = resources->findBackground(backgroundBounds, backgroundScale);
+
+	if (background.isValid())
+		return;
+
+	background = Image(Image::PixelFormat::RGB,
+		jmax(1, roundToInt(getWidth() * scale)),
+		jmax(1, roundToInt(getHeight() * scale)),
+		true);
 
 	Graphics g(background);
+	g.addTransform(AffineTransform::scale(scale));
 
 	Array<float> freqs
 	{
@@ -341,7 +720,7 @@ void ResponseCurveComponent::resized()
 
 	g.setColour(Colours::lightgrey);
 	const int fontHeight = 10;
-	g.setFont(fontHeight);
+	g.setFont(resources->gridFont);
 
 	for (int i = 0; i < freqs.size(); ++i)
 	{
@@ -401,6 +780,8 @@ void ResponseCurveComponent::resized()
 
 		g.drawFittedText(str, r, juce::Justification::centred, 1);
 	}
+
+	resources->addBackground(backgroundBounds, backgroundScale, background);
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea() 
@@ -425,36 +806,125 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
 	return bounds;
 }
 
+//==============================================================================
+DspLoadOverlay::DspLoadOverlay(SimpleEQAudioProcessor& p) : audioProcessor(p)
+{
+	setInterceptsMouseClicks(false, false);
+}
+
+void DspLoadOverlay::visibilityChanged()
+{
+	if (isShowing())
+	{
+		// Whatever piled up while we were hidden is stale
+		audioProcessor.blockStats.clear();
+		resetWindow();
+		text = "DSP: waiting for audio";
+		shownAllocations = 0;
+		startTimerHz(30);
+	}
+	else
+	{
+		stopTimer();
+	}
+}
+
+void DspLoadOverlay::resetWindow()
+{
+	totalBlockSeconds = totalAudioSeconds = totalUpdateSeconds = 0.0;
+	peakLoad = worstBlockMicroseconds = 0.f;
+	redesigns = allocations = 0;
+	windowStart = juce::Time::getMillisecondCounterHiRes();
+}
+
+void DspLoadOverlay::timerCallback()
+{
+	using namespace juce;
+
+	auto sampleRate = audioProcessor.getSampleRate();
+	auto numStats = audioProcessor.blockStats.pop(pending.data(), static_cast<int>(pending.size()));
+
+	for (int i = 0; i < numStats; ++i)
+	{
+		const auto& stats = pending[static_cast<size_t>(i)];
+
+		totalBlockSeconds += stats.blockMicroseconds * 1.0e-6;
+		totalUpdateSeconds += stats.updateMicroseconds * 1.0e-6;
+
+		if (sampleRate > 0.0)
+			totalAudioSeconds += stats.numSamples / sampleRate;
+
+		peakLoad = jmax(peakLoad, stats.load);
+		worstBlockMicroseconds = jmax(worstBlockMicroseconds, stats.blockMicroseconds);
+		redesigns += stats.redesigns;
+		allocations += stats.allocations;
+	}
+
+	if (Time::getMillisecondCounterHiRes() - windowStart < windowMilliseconds || totalAudioSeconds <= 0.0)
+		return;
+
+	text = "DSP " + String(100.0 * totalBlockSeconds / totalAudioSeconds, 1) + "%"
+		+ "  peak " + String(100.f * peakLoad, 1) + "%"
+		+ "  worst block " + String(roundToInt(worstBlockMicroseconds)) + " us"
+		+ "  update " + String(totalBlockSeconds > 0.0 ? roundToInt(100.0 * totalUpdateSeconds / totalBlockSeconds) : 0) + "%"
+		+ "  redesigns " + String(redesigns)
+		+ "  allocations " + (ScopedAllocationCounter::isEnabled() ? String(allocations) : String("n/a"));
+
+	shownAllocations = allocations;
+	resetWindow();
+	repaint();
+}
+
+void DspLoadOverlay::paint(juce::Graphics& g)
+{
+	using namespace juce;
+
+	// Audio thread allocations are always a bug, so make them stand out
+	g.setColour(shownAllocations > 0 ? Colours::red : Colours::lightgrey);
+	g.setFont(resources->overlayFont);
+	g.drawFittedText(text, getLocalBounds(), Justification::centredLeft, 1);
+}
+
+//==============================================================================
+BandControls::BandControls(juce::AudioProcessorValueTreeState& apvts, const ParamIDs::BandIDs& ids) :
+	typeSlider(*apvts.getParameter(ids.type), ""),
+	freqSlider(*apvts.getParameter(ids.freq), "Hz"),
+	gainSlider(*apvts.getParameter(ids.gain), "dB"),
+	qualitySlider(*apvts.getParameter(ids.quality), ""),
+	typeSliderAttachment(apvts, ids.type, typeSlider),
+	freqSliderAttachment(apvts, ids.freq, freqSlider),
+	gainSliderAttachment(apvts, ids.gain, gainSlider),
+	qualitySliderAttachment(apvts, ids.quality, qualitySlider)
+{
+	typeSlider.labels.add({ 0.f, "Off" });
+	typeSlider.labels.add({ 1.f, "Notch" });
+
+	freqSlider.labels.add({ 0.f, "20Hz" });
+	freqSlider.labels.add({ 1.f, "20kHz" });
+
+	gainSlider.labels.add({ 0.f, "-24dB" });
+	gainSlider.labels.add({ 1.f, "24dB" });
+
+	qualitySlider.labels.add({ 0.f, "0.1" });
+	qualitySlider.labels.add({ 1.f, "10" });
+}
+
 //==============================================================================
 SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor(
     SimpleEQAudioProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p),
-	peakFreqSlider(*audioProcessor.apvts.getParameter("Peak Freq"), "Hz"),
-	peakGainSlider(*audioProcessor.apvts.getParameter("Peak Gain"), "dB"),
-	peakQualitySlider(*audioProcessor.apvts.getParameter("Peak Quality"), ""),
-	highCutFreqSlider(*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
-	lowCutFreqSlider(*audioProcessor.apvts.getParameter("LowCut Freq"), "Hz"),
-	highCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "dB/Oct"),
-	lowCutSlopeSlider(*audioProcessor.apvts.getParameter("LowCut Slope"), "db/Oct"),
+	highCutFreqSlider(*audioProcessor.apvts.getParameter(ParamIDs::highCutFreq), "Hz"),
+	lowCutFreqSlider(*audioProcessor.apvts.getParameter(ParamIDs::lowCutFreq), "Hz"),
+	highCutSlopeSlider(*audioProcessor.apvts.getParameter(ParamIDs::highCutSlope), "dB/Oct"),
+	lowCutSlopeSlider(*audioProcessor.apvts.getParameter(ParamIDs::lowCutSlope), "db/Oct"),
 	responseCurveComponent(audioProcessor),
-    peakFreqSliderAttachment(audioProcessor.apvts, "Peak Freq", peakFreqSlider),
-    peakGainSliderAttachment(audioProcessor.apvts, "Peak Gain", peakGainSlider),
-    peakQualitySliderAttachment(audioProcessor.apvts, "Peak Quality", peakQualitySlider),
-    lowCutFreqSliderAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
-    highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider),
-    lowCutSlopeSliderAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
-    highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider)
+	dspLoadOverlay(audioProcessor),
+    lowCutFreqSliderAttachment(audioProcessor.apvts, ParamIDs::lowCutFreq, lowCutFreqSlider),
+    highCutFreqSliderAttachment(audioProcessor.apvts, ParamIDs::highCutFreq, highCutFreqSlider),
+    lowCutSlopeSliderAttachment(audioProcessor.apvts, ParamIDs::lowCutSlope, lowCutSlopeSlider),
+    highCutSlopeSliderAttachment(audioProcessor.apvts, ParamIDs::highCutSlope, highCutSlopeSlider)
 {
 
-	peakFreqSlider.labels.add({ 0.f, "20Hz" });
-	peakFreqSlider.labels.add({ 1.f, "20kHz" });
-
-	peakGainSlider.labels.add({ 0.f, "-24dB" });
-	peakGainSlider.labels.add({ 1.f, "24dB" });
-
-	peakQualitySlider.labels.add({ 0.f, "0.1" });
-	peakQualitySlider.labels.add({ 1.f, "10" });
-
 	lowCutFreqSlider.labels.add({ 0.f, "20Hz" });
 	lowCutFreqSlider.labels.add({ 1.f, "20kHz" });
 
@@ -472,6 +942,29 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor(
     addAndMakeVisible(comp);
   }
 
+  for (int i = 0; i < numParametricBands; ++i)
+  {
+    bandControls[static_cast<size_t>(i)] = std::make_unique<BandControls>(audioProcessor.apvts, ParamIDs::bands[i]);
+
+    for (auto* comp : bandControls[static_cast<size_t>(i)]->getComps())
+      addChildComponent(comp);
+
+    bandSelector.addItem("Band " + juce::String(i + 1), i + 1);
+  }
+
+  bandSelector.onChange = [this] { setSelectedBand(bandSelector.getSelectedItemIndex()); };
+  addAndMakeVisible(bandSelector);
+  setSelectedBand(0);
+
+#if JUCE_MODULE_AVAILABLE_juce_opengl && SIMPLEEQ_USE_OPENGL
+  responseCurveComponent.setOpenGLEnabled(true);
+#endif
+
+  dspLoadButton.setClickingTogglesState(true);
+  dspLoadButton.onClick = [this] { setDspLoadOverlayVisible(dspLoadButton.getToggleState()); };
+  addAndMakeVisible(dspLoadButton);
+  addChildComponent(dspLoadOverlay);
+
   setSize(600, 500);
 }
 
@@ -489,9 +982,30 @@ void SimpleEQAudioProcessorEditor::paint (juce::Graphics& g)
 
 }
 
+void SimpleEQAudioProcessorEditor::setSelectedBand(int index)
+{
+    bandSelector.setSelectedItemIndex(index, juce::dontSendNotification);
+
+    for (size_t i = 0; i < bandControls.size(); ++i)
+        for (auto* comp : bandControls[i]->getComps())
+            comp->setVisible(static_cast<int>(i) == index);
+}
+
+void SimpleEQAudioProcessorEditor::setDspLoadOverlayVisible(bool shouldBeVisible)
+{
+    dspLoadButton.setToggleState(shouldBeVisible, juce::dontSendNotification);
+    dspLoadOverlay.setVisible(shouldBeVisible);
+}
+
 void SimpleEQAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
+
+    // Kept clear of the response curve, which may be covered by an OpenGL surface
+    auto dspLoadArea = bounds.removeFromBottom(18).reduced(4, 1);
+    dspLoadButton.setBounds(dspLoadArea.removeFromRight(36));
+    dspLoadOverlay.setBounds(dspLoadArea);
+
 	float hRatio = 25.f / 100.f;
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * hRatio);
 
@@ -508,18 +1022,27 @@ void SimpleEQAudioProcessorEditor::resized()
     highCutFreqSlider.setBounds(highCutArea.removeFromTop(highCutArea.getHeight() * 0.5));
     highCutSlopeSlider.setBounds(highCutArea);
 
-    peakFreqSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.33));
-    peakGainSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.5));
-    peakQualitySlider.setBounds(bounds);
+    // The selected band's knobs, two by two under the selector. The hidden
+    // bands get the same bounds, so switching is just a visibility change.
+    bandSelector.setBounds(bounds.removeFromTop(24).reduced(4, 2));
+
+    auto bandTopArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
+    auto freqArea = bandTopArea.removeFromLeft(bandTopArea.getWidth() * 0.5);
+    auto qualityArea = bounds.removeFromLeft(bounds.getWidth() * 0.5);
+
+    for (auto& controls : bandControls)
+    {
+        controls->freqSlider.setBounds(freqArea);
+        controls->gainSlider.setBounds(bandTopArea);
+        controls->qualitySlider.setBounds(qualityArea);
+        controls->typeSlider.setBounds(bounds);
+    }
 
 }
 
 std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComps()
 {
     return {
-        &peakFreqSlider,
-        &peakGainSlider,
-        &peakQualitySlider,
         &lowCutFreqSlider,
         &highCutFreqSlider,
         &lowCutSlopeSlider,
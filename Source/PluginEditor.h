@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ChainResponse.h"
+#include "OpenGLResponseRenderer.h"
 
 struct LookAndFeel : juce::LookAndFeel_V4
 {
@@ -19,6 +21,38 @@ struct LookAndFeel : juce::LookAndFeel_V4
         float rotaryStartAngle,
         float rotaryEndAngle,
         juce::Slider&) override;
+
+    // The pieces drawRotarySlider is made of, so sliders can cache the static parts
+    void drawRotarySliderBody(juce::Graphics&, juce::Rectangle<float> bounds);
+
+    // The pointer at angle 0, stopping innerRadius short of the centre
+    juce::Path createRotarySliderPointer(juce::Rectangle<float> bounds, float innerRadius);
+};
+
+// Everything the editors can share, held through a juce::SharedResourcePointer:
+// one copy for every editor in the process, built when the first one opens
+struct EditorResources
+{
+    LookAndFeel lookAndFeel;
+
+    // The knob labels match RotarySliderWithLabels::getTextHeight
+    juce::Font labelFont{ 14.f }, gridFont{ 10.f }, overlayFont{ 12.f };
+
+    // The response curve grid, for the last few sizes and scales it was drawn
+    // at. Images are never drawn into again once they are in here.
+    juce::Image findBackground(juce::Rectangle<int> bounds, float scale) const;
+    void addBackground(juce::Rectangle<int> bounds, float scale, const juce::Image& image);
+
+private:
+    struct CachedBackground
+    {
+        juce::Rectangle<int> bounds;
+        float scale{ 0.f };
+        juce::Image image;
+    };
+
+    std::array<CachedBackground, 4> backgrounds;
+    size_t nextBackground{ 0 };
 };
 
 struct RotarySliderWithLabels : juce::Slider 
@@ -27,9 +61,11 @@ struct RotarySliderWithLabels : juce::Slider
         juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,
         juce::Slider::NoTextBox),
         param(&rap),
+        choiceParam(dynamic_cast<juce::AudioParameterChoice*>(&rap)),
+        floatParam(dynamic_cast<juce::AudioParameterFloat*>(&rap)),
         suffix(unitSuffix)
     {
-        setLookAndFeel(&lnf);
+        setLookAndFeel(&resources->lookAndFeel);
     }
 
     ~RotarySliderWithLabels()
@@ -46,20 +82,42 @@ struct RotarySliderWithLabels : juce::Slider
     juce::Array<LabelPos> labels;
 
     void paint(juce::Graphics& g) override;
+    void resized() override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
 
 private:
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<EditorResources> resources;
 
     juce::RangedAudioParameter* param;
+    juce::AudioParameterChoice* choiceParam;
+    juce::AudioParameterFloat* floatParam;
     juce::String suffix;
+
+    // Knob body and label ring, at the physical scale. Only redrawn when the
+    // size or the scale changes, and not before the first paint.
+    juce::Image staticLayer;
+    float staticLayerScale{ 0.f };
+    bool staticLayerValid{ false };
+
+    void updateStaticLayer();
+
+    // Built in resized() and rotated into place in paint()
+    juce::Path pointer;
+
+    // Only formatted and measured again when the value moves
+    double displayedValue{ std::numeric_limits<double>::quiet_NaN() };
+    juce::String displayString;
+    juce::Rectangle<float> displayStringBounds;
+
+    void updateDisplayString();
 };
 
 struct ResponseCurveComponent : juce::Component,
     juce::AudioProcessorParameter::Listener,
-    juce::Timer
+    juce::ChangeListener,
+    private juce::AsyncUpdater
 {
     ResponseCurveComponent(SimpleEQAudioProcessor&);
     ~ResponseCurveComponent();
@@ -68,7 +126,17 @@ struct ResponseCurveComponent : juce::Component,
 
 	void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
 
-	void timerCallback() override;
+	// New analyzer frames, or a new snapshot from the engine
+	void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+
+	// Upper bound on how often the curve and spectra are redrawn, or 0 to follow
+	// the display's refresh rate
+	void setMaximumFrameRate(double framesPerSecond) { maximumFrameRate = framesPerSecond; }
+
+	// Draws with OpenGL when juce_opengl is available and the machine supports it,
+	// otherwise keeps painting with juce::Graphics. Off by default, the editor
+	// only turns it on when SIMPLEEQ_USE_OPENGL is set.
+	void setOpenGLEnabled(bool shouldUseOpenGL);
 
     void paint(juce::Graphics& g) override;
     void resized() override;
@@ -77,17 +145,139 @@ private:
 
 	juce::Atomic<bool> parameterChanged{ false };
 
-    MonoChain monoChain;
+	// Updates are drawn on the display's vblank, and only while something changed
+	// recently and the component is showing. Any change re-attaches it.
+	std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+	double maximumFrameRate{ 60.0 };
+	double lastFrameTime{ 0.0 };
+	int idleFrames{ 0 };
+
+	static constexpr int maxIdleFrames = 8;
+
+	// Automation may arrive on the audio thread, where all we do is set the flag.
+	// The frames are started again by the engine's change message, which the
+	// worker sends once it has published the matching snapshot.
+	void startFrames();
+	void onVBlank();
+	void handleAsyncUpdate() override;
+	void visibilityChanged() override;
+	void parentHierarchyChanged() override;
+
+	// The parameter and analyzer listeners are only registered while we are
+	// showing, so a closed or hidden editor costs nothing
+	bool active{ false };
+	std::vector<juce::AudioProcessorParameter*> curveParameters;
+
+	void updateActive();
+
+	// Set by resized(). The curve, spectra and grid are only rebuilt for the new
+	// size when a frame is actually drawn.
+	bool layoutValid{ false };
+
+	void ensureLayout();
+
+    // Magnitudes in dB for each pixel column of the analysis area, per stage, from
+    // the engine's snapshot. Only the bands whose version moved are re-evaluated.
+    // paint() only turns the summed response into a Path.
+    std::vector<float> lowCutMagnitudes, highCutMagnitudes, responseMagnitudes;
+    std::array<std::vector<float>, numParametricBands> bandMagnitudes;
+    std::vector<double> columnFrequencies;
+    ChainResponseEvaluator responseEvaluator;
+    juce::uint32 cachedLowCutVersion{ 0 }, cachedHighCutVersion{ 0 };
+    std::array<juce::uint32, numParametricBands> cachedBandVersions{};
+    int cachedWidth{ 0 };
+    double cachedSampleRate{ 0.0 };
+
+    void updateResponseCache();
+
+    juce::Path responseCurve;
+
+    void updateResponsePath();
 
-    void updateChain();
+    // One path per analyzer spectrum, rebuilt when a new frame arrives
+    std::array<juce::Path, SpectrumAnalyzer::NumSpectra> spectrumPaths;
 
+    void updateSpectrumPaths();
+
+    // The grid and labels, at the physical scale of the display we're on.
+    // Only redrawn when the size or the scale changes.
     juce::Image background;
+    float backgroundScale{ 1.f };
+    juce::Rectangle<int> backgroundBounds;
+
+    juce::SharedResourcePointer<EditorResources> resources;
+
+    void updateBackground();
+
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+    std::unique_ptr<OpenGLResponseRenderer> glRenderer;
+#endif
+
+    // Hands the current background and curves to the GL renderer, if there is one
+    void updateRenderer();
 
     juce::Rectangle<int> getRenderArea();
 
     juce::Rectangle<int> getAnalysisArea();
 };
 
+// One line readout of the processor's BlockStats: average and peak DSP load,
+// worst case block time, redesigns and audio thread allocations. Only reads
+// the ring while it is showing. Allocations read "n/a" in the plugin, which
+// never counts them (see SIMPLEEQ_DETECT_ALLOCATIONS).
+struct DspLoadOverlay : juce::Component,
+    private juce::Timer
+{
+    DspLoadOverlay(SimpleEQAudioProcessor&);
+
+    void paint(juce::Graphics& g) override;
+private:
+    SimpleEQAudioProcessor& audioProcessor;
+    juce::SharedResourcePointer<EditorResources> resources;
+
+    // Drained into here on the message thread
+    std::array<BlockStats, BlockStatsRing::capacity> pending;
+
+    // Totals over the current window, shown and reset every windowMilliseconds
+    static constexpr int windowMilliseconds = 500;
+
+    double totalBlockSeconds{ 0.0 }, totalAudioSeconds{ 0.0 }, totalUpdateSeconds{ 0.0 };
+    float peakLoad{ 0.f }, worstBlockMicroseconds{ 0.f };
+    juce::uint32 redesigns{ 0 }, allocations{ 0 };
+    double windowStart{ 0.0 };
+
+    // What paint() shows: the text and allocations of the last finished window
+    juce::String text;
+    juce::uint32 shownAllocations{ 0 };
+
+    void timerCallback() override;
+    void visibilityChanged() override;
+    void resetWindow();
+};
+
+// The knobs of one parametric band, attached to its parameters. The editor
+// builds them for every band and only shows the selected band's.
+struct BandControls
+{
+    BandControls(juce::AudioProcessorValueTreeState& apvts, const ParamIDs::BandIDs& ids);
+
+    RotarySliderWithLabels
+        typeSlider,
+        freqSlider,
+        gainSlider,
+        qualitySlider;
+
+    using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+
+    Attachment
+        typeSliderAttachment,
+        freqSliderAttachment,
+        gainSliderAttachment,
+        qualitySliderAttachment;
+
+    std::vector<juce::Component*> getComps() { return { &typeSlider, &freqSlider, &gainSlider, &qualitySlider }; }
+};
+
 //==============================================================================
 /**
 */
@@ -101,29 +291,36 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    // Shows the DSP load readout under the sliders
+    void setDspLoadOverlayVisible(bool shouldBeVisible);
+
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleEQAudioProcessor& audioProcessor;
 
     RotarySliderWithLabels 
-        peakFreqSlider,
-        peakGainSlider,
-        peakQualitySlider,
         lowCutFreqSlider,
         highCutFreqSlider,
         lowCutSlopeSlider,
         highCutSlopeSlider;
 
+    // Every parametric band has its own knobs, the selector picks whose are showing
+    std::array<std::unique_ptr<BandControls>, numParametricBands> bandControls;
+    juce::ComboBox bandSelector;
+
+    void setSelectedBand(int index);
+
     ResponseCurveComponent responseCurveComponent;
 
+    // Hidden unless the button is toggled on
+    DspLoadOverlay dspLoadOverlay;
+    juce::TextButton dspLoadButton{ "DSP" };
+
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
 
     Attachment
-        peakFreqSliderAttachment,
-        peakGainSliderAttachment,
-        peakQualitySliderAttachment,
 		lowCutFreqSliderAttachment,
 		highCutFreqSliderAttachment,
 		lowCutSlopeSliderAttachment,
@@ -22,6 +22,7 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                        )
 #endif
 {
+    resolveStateParameters();
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
@@ -63,7 +64,21 @@ bool SimpleEQAudioProcessor::isMidiEffect() const
 
 double SimpleEQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    auto sampleRate = getSampleRate();
+
+    if (sampleRate <= 0.0)
+        return 0.0;
+
+    return getTailLengthInSamples(parameters.isLinearPhase()) / sampleRate;
+}
+
+int SimpleEQAudioProcessor::getTailLengthInSamples(bool linearPhase) const
+{
+    if (linearPhase)
+        return linearPhaseEngine.getTailLengthInSamples();
+
+    // The oversamplers delay the tail by their latency on top
+    return juce::roundToInt(coefficientEngine.getTailLengthSeconds() * getSampleRate()) + pendingLatency.load();
 }
 
 int SimpleEQAudioProcessor::getNumPrograms()
@@ -96,16 +111,55 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
+    auto numChannels = static_cast<size_t>(getTotalNumOutputChannels());
+
     juce::dsp::ProcessSpec spec;
 
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    // Big enough for the 4x oversampled blocks
+    spec.maximumBlockSize = static_cast<juce::uint32>(samplesPerBlock * 4);
+    spec.numChannels = static_cast<juce::uint32>(numChannels);
     spec.sampleRate = sampleRate;
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    withRealtimeFilters([&](auto& filters) { filters.prepare(spec, samplesPerBlock); });
 
+    highQualityOversampler = std::make_unique<juce::dsp::Oversampling<double>>(numChannels, 2,
+        juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, true, true);
+    highQualityOversampler->initProcessing(static_cast<size_t>(samplesPerBlock));
+
+    highQualityBuffer.setSize(isUsingDoublePrecision() ? 0 : static_cast<int>(numChannels), samplesPerBlock);
+    highQualityFilterBank.prepare(spec);
+
+    oversamplingFactor = 1;
+    preparedBlockSize = samplesPerBlock;
+
+    wasNonRealtime = isNonRealtime();
+    coefficientEngine.setCacheWarmingFactor(wasNonRealtime ? highQualityOversamplingFactor : 0);
+    coefficientEngine.prepare(sampleRate);
     updateFilters();
+    lastEngineRedesigns = coefficientEngine.getNumRedesigns();
+
+    auto chainSettings = parameters.getChainSettings();
+
+    smoother.reset(sampleRate, 0.05);
+    smoother.setCurrentAndTargetValues(chainSettings);
+
+    highQualitySmoother.reset(sampleRate, 0.05);
+    highQualitySmoother.setCurrentAndTargetValues(chainSettings);
+    updateHighQualityFilters(chainSettings, true);
+
+    analyzer.prepare(sampleRate, samplesPerBlock);
+
+    juce::dsp::ProcessSpec linearPhaseSpec{ sampleRate, static_cast<juce::uint32>(samplesPerBlock), spec.numChannels };
+    linearPhaseEngine.prepare(linearPhaseSpec);
+    linearPhaseBuffer.setSize(isUsingDoublePrecision() ? static_cast<int>(numChannels) : 0, samplesPerBlock);
+
+    wasLinearPhase = parameters.isLinearPhase();
+    linearPhaseEngine.setEnabled(wasLinearPhase);
+
+    // Not on the audio thread, so the host can hear about it straight away
+    cancelPendingUpdate();
+    pendingLatency.store(getLatencyForRenderMode(wasNonRealtime));
+    setLatencySamples(pendingLatency.load());
 }
 
 void SimpleEQAudioProcessor::releaseResources()
@@ -121,12 +175,9 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets the same EQ, so any layout works as long as there is
+    // something to process: mono, stereo, surround or ambisonics.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -141,8 +192,25 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 #endif
 
 void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer);
+}
+
+void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer);
+}
+
+template<typename SampleType>
+void SimpleEQAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
+    ScopedAllocationCounter allocationCounter;
+    auto blockStart = juce::Time::getHighResolutionTicks();
+
+    updateTicks = 0;
+    audioThreadRedesigns = 0;
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -155,18 +223,404 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    updateFilters();
+    analyzer.pushPreEQ(buffer);
+
+    auto filterStart = juce::Time::getHighResolutionTicks();
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    if (canSkipFilters(buffer))
+        buffer.clear();
+    else
+        processFilters(buffer);
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    auto filterTicks = juce::Time::getHighResolutionTicks() - filterStart - updateTicks;
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    analyzer.pushPostEQ(buffer);
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    BlockStats stats;
+    stats.updateMicroseconds = ticksToMicroseconds(updateTicks);
+    stats.filterMicroseconds = ticksToMicroseconds(filterTicks);
+    stats.blockMicroseconds = ticksToMicroseconds(juce::Time::getHighResolutionTicks() - blockStart);
+    stats.numSamples = buffer.getNumSamples();
+
+    if (stats.numSamples > 0)
+        stats.load = static_cast<float>(stats.blockMicroseconds * 1.0e-6 * getSampleRate() / stats.numSamples);
+
+    auto engineRedesigns = coefficientEngine.getNumRedesigns();
+    stats.redesigns = engineRedesigns - lastEngineRedesigns + audioThreadRedesigns;
+    lastEngineRedesigns = engineRedesigns;
+
+    stats.allocations = allocationCounter.getCount();
+
+    blockStats.push(stats);
+}
+
+template<typename SampleType>
+bool SimpleEQAudioProcessor::canSkipFilters(const juce::AudioBuffer<SampleType>& buffer)
+{
+    auto numSamples = buffer.getNumSamples();
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        if (buffer.getMagnitude(ch, 0, numSamples) > static_cast<SampleType>(silenceThreshold))
+        {
+            silentSamples = 0;
+            isSuspended = false;
+            return false;
+        }
+    }
+
+    // What is still ringing from before the silence has to be out by the start
+    // of this block, and the filters have to agree
+    auto tailHasPassed = silentSamples >= getTailLengthInSamples(wasLinearPhase);
+    silentSamples += numSamples;
+
+    if (!tailHasPassed || !areFiltersQuiet<SampleType>())
+        return false;
+
+    if (!isSuspended)
+    {
+        // Whatever is left in the state is below the threshold: start from a
+        // clean slate when the input comes back
+        isSuspended = true;
+
+        withRealtimeFilters([this](auto& filters) { filters.reset(oversamplingFactor); });
+        highQualityFilterBank.reset();
+        highQualityOversampler->reset();
+        linearPhaseEngine.reset();
+        previousSubBlockSize = 0;
+    }
+
+    return true;
+}
+
+template<typename SampleType>
+bool SimpleEQAudioProcessor::areFiltersQuiet() const
+{
+    // The convolution has no state we can look at, so the tail length has to do
+    if (wasLinearPhase)
+        return true;
+
+    if (wasNonRealtime)
+        return highQualityFilterBank.getStateMagnitude() < silenceThreshold;
+
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleFilters.filterBank.getStateMagnitude() < silenceThreshold;
+    else
+        return floatFilters.filterBank.getStateMagnitude() < silenceThreshold;
+}
+
+template<typename SampleType>
+void SimpleEQAudioProcessor::processFilters(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto linearPhase = parameters.isLinearPhase();
+
+    if (linearPhase != wasLinearPhase)
+        setLinearPhase(linearPhase);
+
+    auto nonRealtime = isNonRealtime();
+
+    // Offline, the kernel for the current settings is built right here, so a
+    // bounce doesn't depend on when the worker got to it
+    // The convolution's buffers only hold a prepared block too
+    auto processLinearPhase = [this, nonRealtime](juce::dsp::AudioBlock<float> block)
+    {
+        auto numSamples = block.getNumSamples();
+        auto chunkSize = static_cast<size_t>(preparedBlockSize);
+
+        for (size_t start = 0; start < numSamples && chunkSize > 0; start += chunkSize)
+        {
+            auto chunk = block.getSubBlock(start, juce::jmin(chunkSize, numSamples - start));
+            juce::dsp::ProcessContextReplacing<float> context(chunk);
+
+            if (nonRealtime)
+                linearPhaseEngine.processNonRealtime(context);
+            else
+                linearPhaseEngine.process(context);
+        }
+    };
+
+    if (linearPhase)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            processLinearPhase(juce::dsp::AudioBlock<float>(buffer));
+        }
+        else
+        {
+            auto numChannels = juce::jmin(buffer.getNumChannels(), linearPhaseBuffer.getNumChannels());
+            auto numSamples = buffer.getNumSamples();
+            auto chunkSize = preparedBlockSize;
+
+            // Through the float buffer one prepared block at a time
+            for (int start = 0; start < numSamples && chunkSize > 0; start += chunkSize)
+            {
+                auto length = juce::jmin(chunkSize, numSamples - start);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* src = buffer.getReadPointer(ch, start);
+                    auto* dst = linearPhaseBuffer.getWritePointer(ch);
+
+                    for (int i = 0; i < length; ++i)
+                        dst[i] = static_cast<float>(src[i]);
+                }
+
+                processLinearPhase(juce::dsp::AudioBlock<float>(linearPhaseBuffer.getArrayOfWritePointers(),
+                    static_cast<size_t>(numChannels), static_cast<size_t>(length)));
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* src = linearPhaseBuffer.getReadPointer(ch);
+                    auto* dst = buffer.getWritePointer(ch, start);
+
+                    for (int i = 0; i < length; ++i)
+                        dst[i] = src[i];
+                }
+            }
+        }
+
+        return;
+    }
+
+    if (nonRealtime != wasNonRealtime)
+        setRenderMode(nonRealtime);
+
+    if (nonRealtime)
+    {
+        processHighQuality(buffer);
+        return;
+    }
+
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+    auto& filters = getRealtimeFilters<SampleType>();
+
+    auto numSamples = buffer.getNumSamples();
+    auto subBlockSize = getSmoothingSubBlockSize();
+
+    if (subBlockSize > 0)
+    {
+        // When smoothing has just been switched on, start ramping from where we are
+        if (previousSubBlockSize == 0)
+            smoother.setCurrentAndTargetValues(parameters.getChainSettings());
+        else
+            smoother.setTargetValues(parameters.getChainSettings());
+
+        // Land exactly on the targets where the ramps end
+        scheduler.addChangePoint(smoother.getSamplesUntilSettled(), numSamples);
+    }
+
+    previousSubBlockSize = subBlockSize;
+
+    // Without smoothing, large host blocks are still cut up so that a set the
+    // worker publishes meanwhile is picked up within maxSubBlockSize samples
+    scheduler.setMaximumSubBlockSize(subBlockSize > 0 ? subBlockSize : maxSubBlockSize);
+
+    scheduler.process(numSamples, [&](int start, int length)
+    {
+        // Parameters can move while we process, e.g. from the editor
+        if (start > 0 && subBlockSize > 0)
+        {
+            auto samplesUntilSettled = smoother.getSamplesUntilSettled();
+            smoother.setTargetValues(parameters.getChainSettings());
+
+            if (smoother.getSamplesUntilSettled() != samplesUntilSettled)
+                scheduler.addChangePoint(start + smoother.getSamplesUntilSettled(), numSamples);
+        }
+
+        if (subBlockSize == 0 || !smoother.isSmoothing())
+            updateFilters();
+        else
+            updateSmoothedFilters(length);
+
+        filters.process(block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(length)), oversamplingFactor);
+    });
+}
+
+void SimpleEQAudioProcessor::setOversamplingFactor(int newFactor)
+{
+    jassert(newFactor == 1 || newFactor == 2 || newFactor == 4);
+    oversamplingFactor = newFactor;
+
+    // The filter state belongs to the old rate
+    withRealtimeFilters([this](auto& filters) { filters.reset(oversamplingFactor); });
+
+    reportLatency(getLatencyForRenderMode(false));
+}
+
+void SimpleEQAudioProcessor::reportLatency(int latencyInSamples)
+{
+    if (pendingLatency.exchange(latencyInSamples) != latencyInSamples)
+        triggerAsyncUpdate();
+}
+
+void SimpleEQAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(pendingLatency.load());
+}
+
+void SimpleEQAudioProcessor::setRenderMode(bool nonRealtime)
+{
+    wasNonRealtime = nonRealtime;
+
+    // The worker puts the settled high quality designs in the shared cache
+    coefficientEngine.setCacheWarmingFactor(nonRealtime ? highQualityOversamplingFactor : 0);
+
+    // Start the engine we switch to from a clean state, nothing here allocates
+    if (nonRealtime)
+    {
+        auto chainSettings = parameters.getChainSettings();
+
+        highQualityFilterBank.reset();
+        highQualityOversampler->reset();
+        highQualitySmoother.setCurrentAndTargetValues(chainSettings);
+        updateHighQualityFilters(chainSettings, true);
+    }
+    else
+    {
+        withRealtimeFilters([this](auto& filters) { filters.reset(oversamplingFactor); });
+        previousSubBlockSize = 0;
+    }
+
+    reportLatency(getLatencyForRenderMode(nonRealtime));
+}
+
+void SimpleEQAudioProcessor::setLinearPhase(bool linearPhase)
+{
+    wasLinearPhase = linearPhase;
+    linearPhaseEngine.setEnabled(linearPhase);
+
+    // Neither side has seen the audio in between, so start both from silence
+    linearPhaseEngine.reset();
+    withRealtimeFilters([this](auto& filters) { filters.reset(oversamplingFactor); });
+    highQualityFilterBank.reset();
+    previousSubBlockSize = 0;
+
+    reportLatency(getLatencyForRenderMode(wasNonRealtime));
+}
+
+int SimpleEQAudioProcessor::getLatencyForRenderMode(bool nonRealtime) const
+{
+    if (wasLinearPhase)
+        return linearPhaseEngine.getLatencyInSamples();
+
+    if (nonRealtime)
+        return juce::roundToInt(highQualityOversampler->getLatencyInSamples());
+
+    if (isUsingDoublePrecision())
+        return doubleFilters.getLatencyInSamples(oversamplingFactor);
+
+    return floatFilters.getLatencyInSamples(oversamplingFactor);
+}
+
+void SimpleEQAudioProcessor::updateHighQualityFilters(const ChainSettings& chainSettings, bool forceUpdate)
+{
+    ScopedTicks timing(updateTicks);
+
+    auto sampleRate = getSampleRate() * highQualityOversamplingFactor;
+    auto bands = forceUpdate ? CoefficientEngine::AllBands : getChangedBands(highQualitySettings, chainSettings);
+
+    if (bands != 0)
+        ++audioThreadRedesigns;
+
+    if (bands & CoefficientEngine::LowCutBand)
+    {
+        coefficientCache->designLowCutFilter(highQualityCoefficients.lowCut, chainSettings, sampleRate, CoefficientCache::FindOnly);
+        highQualityFilterBank.setLowCut(highQualityCoefficients.lowCut);
+    }
+
+    if (bands & CoefficientEngine::HighCutBand)
+    {
+        coefficientCache->designHighCutFilter(highQualityCoefficients.highCut, chainSettings, sampleRate, CoefficientCache::FindOnly);
+        highQualityFilterBank.setHighCut(highQualityCoefficients.highCut);
+    }
+
+    for (int i = 0; i < numParametricBands; ++i)
+    {
+        if (bands & CoefficientEngine::getParametricBand(i))
+        {
+            auto& band = highQualityCoefficients.bands[static_cast<size_t>(i)];
+
+            coefficientCache->designBandFilter(band, chainSettings.bands[static_cast<size_t>(i)], sampleRate, CoefficientCache::FindOnly);
+            highQualityFilterBank.setBand(i, band);
+        }
+    }
+
+    highQualitySettings = chainSettings;
+}
+
+template<typename SampleType>
+void SimpleEQAudioProcessor::processHighQuality(juce::AudioBuffer<SampleType>& buffer)
+{
+    // The oversampler and the conversion buffer hold one prepared block
+    auto numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples && preparedBlockSize > 0; start += preparedBlockSize)
+        processHighQualityChunk(buffer, start, juce::jmin(preparedBlockSize, numSamples - start));
+}
+
+template<typename SampleType>
+void SimpleEQAudioProcessor::processHighQualityChunk(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    constexpr bool convert = !std::is_same_v<SampleType, double>;
+
+    auto numChannels = buffer.getNumChannels();
+    juce::dsp::AudioBlock<double> block;
+
+    if constexpr (convert)
+    {
+        numChannels = juce::jmin(numChannels, highQualityBuffer.getNumChannels());
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* src = buffer.getReadPointer(ch, startSample);
+            auto* dst = highQualityBuffer.getWritePointer(ch);
+
+            for (int i = 0; i < numSamples; ++i)
+                dst[i] = src[i];
+        }
+
+        block = juce::dsp::AudioBlock<double>(highQualityBuffer.getArrayOfWritePointers(),
+            static_cast<size_t>(numChannels), static_cast<size_t>(numSamples));
+    }
+    else
+    {
+        block = juce::dsp::AudioBlock<double>(buffer).getSubBlock(static_cast<size_t>(startSample),
+            static_cast<size_t>(numSamples));
+    }
+
+    auto oversampledBlock = highQualityOversampler->processSamplesUp(block);
+
+    highQualitySmoother.setTargetValues(parameters.getChainSettings());
+
+    if (!highQualitySmoother.isSmoothing())
+    {
+        updateHighQualityFilters(highQualitySmoother.skip(numSamples), false);
+        highQualityFilterBank.process(oversampledBlock);
+    }
+    else
+    {
+        // One host sample at a time, i.e. highQualityOversamplingFactor oversampled ones
+        for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i)
+        {
+            updateHighQualityFilters(highQualitySmoother.skip(1), false);
+            highQualityFilterBank.process(oversampledBlock.getSubBlock(i * highQualityOversamplingFactor,
+                highQualityOversamplingFactor));
+        }
+    }
+
+    highQualityOversampler->processSamplesDown(block);
+
+    if constexpr (convert)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* src = highQualityBuffer.getReadPointer(ch);
+            auto* dst = buffer.getWritePointer(ch, startSample);
+
+            for (int i = 0; i < numSamples; ++i)
+                dst[i] = static_cast<float>(src[i]);
+        }
+    }
 }
 
 //==============================================================================
@@ -182,111 +636,237 @@ juce::AudioProcessorEditor* SimpleEQAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// Parameters in the order the binary state stores them. Append only: a
+// version that adds parameters still reads (and writes) these first.
+static const char* const stateParameterIDs[] =
+{
+    ParamIDs::lowCutFreq,
+    ParamIDs::highCutFreq,
+    ParamIDs::peakFreq,
+    ParamIDs::peakGain,
+    ParamIDs::peakQuality,
+    ParamIDs::lowCutSlope,
+    ParamIDs::highCutSlope,
+    ParamIDs::oversampling,
+    ParamIDs::smoothing,
+    ParamIDs::linearPhase
+};
+
+// ...followed by the type of band 1, then the type, frequency, gain and Q of
+// each of the bands after it
+static_assert(std::size(stateParameterIDs) + 1 + 4 * (numParametricBands - 1) == SimpleEQAudioProcessor::numStateParameters,
+    "numStateParameters is out of date");
+
+// "SEQB", then the version and the number of values, then one float per
+// parameter, not normalised, all little endian
+static constexpr int stateMagic = 0x42514553;
+static constexpr int stateVersion = 1;
+
+void SimpleEQAudioProcessor::resolveStateParameters()
+{
+    size_t numResolved = 0;
+
+    auto resolve = [&](const char* parameterID)
+    {
+        stateParameters[numResolved] = apvts.getParameter(parameterID);
+        jassert(stateParameters[numResolved] != nullptr);
+        ++numResolved;
+    };
+
+    for (auto* parameterID : stateParameterIDs)
+        resolve(parameterID);
+
+    resolve(ParamIDs::bands[0].type);
+
+    for (int i = 1; i < numParametricBands; ++i)
+    {
+        const auto& ids = ParamIDs::bands[i];
+
+        resolve(ids.type);
+        resolve(ids.freq);
+        resolve(ids.gain);
+        resolve(ids.quality);
+    }
+
+    jassert(numResolved == stateParameters.size());
+}
+
 void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
     juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+
+    mos.writeInt(stateMagic);
+    mos.writeInt(stateVersion);
+    mos.writeInt(numStateParameters);
+
+    for (auto* parameter : stateParameters)
+        mos.writeFloat(parameter->convertFrom0to1(parameter->getValue()));
 }
 
 void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream mis(data, static_cast<size_t>(sizeInBytes), false);
+
+    if (sizeInBytes < 12 || mis.readInt() != stateMagic)
+    {
+        setLegacyStateInformation(data, sizeInBytes);
+        return;
+    }
+
+    auto version = mis.readInt();
+    auto numValues = mis.readInt();
+
+    // Truncated, or not something we wrote
+    if (version < 1 || numValues < 0 || mis.getNumBytesRemaining() < static_cast<juce::int64>(numValues) * 4)
+    {
+        jassertfalse;
+        return;
+    }
+
+    // Values this build doesn't know about are skipped, missing ones keep their
+    // current value. A restore isn't an edit, so the host isn't told about each
+    // value: only the APVTS and the other listeners hear about them.
+    auto numKnown = juce::jmin(numValues, numStateParameters);
+
+    for (int i = 0; i < numKnown; ++i)
+    {
+        auto* parameter = stateParameters[static_cast<size_t>(i)];
+        auto value = parameter->convertTo0to1(mis.readFloat());
+
+        if (value != parameter->getValue())
+        {
+            parameter->setValue(value);
+            parameter->sendValueChangedMessageToListeners(value);
+        }
+    }
+
+    // Nothing is designed here, like the legacy path: the worker picks it up
+    coefficientEngine.invalidate();
+}
+
+void SimpleEQAudioProcessor::setLegacyStateInformation (const void* data, int sizeInBytes)
 {
     auto tree = juce::ValueTree::readFromData(data, static_cast<size_t>(sizeInBytes));
     if (tree.isValid()) 
     {
         apvts.replaceState(tree);
-        updateFilters();
+        coefficientEngine.invalidate();
     }
 }
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
 {
-    ChainSettings settings;
-
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    return ParameterBindings(apvts).getChainSettings();
+}
 
-    return settings;
+int getOversamplingFactor(juce::AudioProcessorValueTreeState& apvts)
+{
+    return ParameterBindings(apvts).getOversamplingFactor();
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+void SimpleEQAudioProcessor::updateBandFilter(int index, const BandCoefficients& bandCoefficients)
 {
-	return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-		chainSettings.peakFreq, chainSettings.peakQuality,
-		juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    withRealtimeFilters([&](auto& filters) { filters.filterBank.setBand(index, bandCoefficients); });
 }
 
-void SimpleEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings) 
+void SimpleEQAudioProcessor::updateLowCutFilter(const CutCoefficients& lowCutCoefficients)
 {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    withRealtimeFilters([&](auto& filters) { filters.filterBank.setLowCut(lowCutCoefficients); });
+}
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+void SimpleEQAudioProcessor::updateHighCutFilter(const CutCoefficients& highCutCoefficients)
+{
+    withRealtimeFilters([&](auto& filters) { filters.filterBank.setHighCut(highCutCoefficients); });
 }
 
-void SimpleEQAudioProcessor::updateLowCutFilter(const ChainSettings& chainSettings)
+void SimpleEQAudioProcessor::updateFilters()
 {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    ScopedTicks timing(updateTicks);
 
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+    // Everything was designed on the worker: we only pick up the newest set.
+    // Offline renders never get here, the high quality engine designs its own.
+    if (!coefficientEngine.acquire())
+        return;
 
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-}
+    const auto& chainCoefficients = coefficientEngine.getPublishedCoefficients();
 
-void SimpleEQAudioProcessor::updateHighCutFilter(const ChainSettings& chainSettings)
-{
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    if (chainCoefficients.oversamplingFactor != oversamplingFactor)
+        setOversamplingFactor(chainCoefficients.oversamplingFactor);
 
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    updateLowCutFilter(chainCoefficients.lowCut);
+    updateHighCutFilter(chainCoefficients.highCut);
 
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    for (int i = 0; i < numParametricBands; ++i)
+        updateBandFilter(i, chainCoefficients.bands[static_cast<size_t>(i)]);
 }
 
-void SimpleEQAudioProcessor::updateFilters()
+int SimpleEQAudioProcessor::getSmoothingSubBlockSize() const
 {
-    auto chainSettings = getChainSettings(apvts);
+    // Matches the choices of the "Smoothing" parameter
+    static constexpr int subBlockSizes[] = { 0, 16, 32, 64, 128 };
 
-    updateLowCutFilter(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilter(chainSettings);
+    return subBlockSizes[juce::jlimit(0, 4, parameters.getSmoothingIndex())];
 }
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacements)
+void SimpleEQAudioProcessor::updateSmoothedFilters(int numSamples)
 {
-    *old = *replacements;
-}
+    ScopedTicks timing(updateTicks);
+
+    // Only the bands that are still ramping need a new design, and any whose
+    // slope or type just changed, which follow straight away
+    auto bands = smoother.getSmoothingBands() | smoother.takeDiscreteChanges();
+    auto chainSettings = smoother.skip(numSamples);
+    auto sampleRate = getSampleRate() * oversamplingFactor;
 
+    if (bands != 0)
+        ++audioThreadRedesigns;
+
+    if (bands & CoefficientEngine::LowCutBand)
+    {
+        coefficientCache->designLowCutFilter(smoothedCoefficients.lowCut, chainSettings, sampleRate, CoefficientCache::FindOnly);
+        updateLowCutFilter(smoothedCoefficients.lowCut);
+    }
+
+    if (bands & CoefficientEngine::HighCutBand)
+    {
+        coefficientCache->designHighCutFilter(smoothedCoefficients.highCut, chainSettings, sampleRate, CoefficientCache::FindOnly);
+        updateHighCutFilter(smoothedCoefficients.highCut);
+    }
+
+    for (int i = 0; i < numParametricBands; ++i)
+    {
+        if (bands & CoefficientEngine::getParametricBand(i))
+        {
+            auto& band = smoothedCoefficients.bands[static_cast<size_t>(i)];
+
+            coefficientCache->designBandFilter(band, chainSettings.bands[static_cast<size_t>(i)], sampleRate, CoefficientCache::FindOnly);
+            updateBandFilter(i, band);
+        }
+    }
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::createParameterLayout()
 {
 
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq", "LowCut Freq", 
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ParamIDs::lowCutFreq, ParamIDs::lowCutFreq, 
         juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 
         20.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq", "HighCut Freq",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ParamIDs::highCutFreq, ParamIDs::highCutFreq,
         juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
         20000.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq", "Peak Freq",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ParamIDs::peakFreq, ParamIDs::peakFreq,
         juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
         750.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain", "Peak Gain",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ParamIDs::peakGain, ParamIDs::peakGain,
         juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 0.25f),
         0.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality", "Peak Quality",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ParamIDs::peakQuality, ParamIDs::peakQuality,
         juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 0.25f),
         1.f));
 
@@ -298,8 +878,49 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
         stringArray.add(str);
     }
 
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(ParamIDs::lowCutSlope, ParamIDs::lowCutSlope, stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(ParamIDs::highCutSlope, ParamIDs::highCutSlope, stringArray, 0));
+
+    // Runs the whole chain at 2x or 4x the host rate, so the bilinear designs
+    // don't cramp near Nyquist
+    layout.add(std::make_unique<juce::AudioParameterChoice>(ParamIDs::oversampling, ParamIDs::oversampling,
+        juce::StringArray{ "Off", "2x", "4x" }, 0));
+
+    // Sub-block size used to follow automation ramps, "Off" updates once per block
+    layout.add(std::make_unique<juce::AudioParameterChoice>(ParamIDs::smoothing, ParamIDs::smoothing,
+        juce::StringArray{ "Off", "16 Samples", "32 Samples", "64 Samples", "128 Samples" }, 0));
+
+    // Same magnitude response without the phase shift, for a few thousand samples of latency
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParamIDs::linearPhase, ParamIDs::linearPhase, false));
+
+    // The parametric bands. Band 1 is the peak band above, which only gets its
+    // type here: the parameters are appended so existing indices don't move.
+    // The others start out off, spread over the spectrum.
+
+    juce::StringArray bandTypes{ "Off", "Peak", "Low Shelf", "High Shelf", "Notch" };
+
+    for (int i = 0; i < numParametricBands; ++i)
+    {
+        const auto& ids = ParamIDs::bands[i];
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.type, ids.type, bandTypes,
+            i == 0 ? Band_Peak : Band_Off));
+
+        if (i == 0)
+            continue;
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.freq, ids.freq,
+            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
+            defaultBandFrequencies[i]));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.gain, ids.gain,
+            juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 0.25f),
+            0.f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.quality, ids.quality,
+            juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 0.25f),
+            1.f));
+    }
 
     return layout;
 }
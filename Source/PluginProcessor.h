@@ -9,215 +9,118 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "MonoChain.h"
+#include "Parameters.h"
+#include "CoefficientEngine.h"
+#include "CoefficientCache.h"
+#include "ChainSmoother.h"
+#include "SubBlockScheduler.h"
+#include "SIMDChain.h"
+#include "LinearPhaseEngine.h"
+
+#include "SpectrumAnalyzer.h"
+#include "Instrumentation.h"
 
 #include <array>
-template<typename T>
-struct Fifo
+#include <atomic>
+#include <type_traits>
+
+// One-off lookups by ID. Anything called per block or per frame should keep
+// a ParameterBindings instead.
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+
+// 1, 2 or 4, from the "Oversampling" parameter
+int getOversamplingFactor(juce::AudioProcessorValueTreeState& apvts);
+
+// Writes in place, the Filter must already hold second order Coefficients
+template<typename SampleType>
+void updateCoefficients(juce::ReferenceCountedObjectPtr<juce::dsp::IIR::Coefficients<SampleType>>& old,
+    const BiquadCoefficients& replacements)
 {
-    void prepare(int numChannels, int numSamples)
-    {
-        for (auto& buffer : buffers)
-        {
-            buffer.setSize(numChannels,
-                numSamples,
-                false,  // Clear everything
-                true,   // including extra space
-                true);  // avoid reallocating if you can
+    jassert(old->coefficients.size() == 5);
+
+    auto* c = old->getRawCoefficients();
+    c[0] = static_cast<SampleType>(replacements.b0);
+    c[1] = static_cast<SampleType>(replacements.b1);
+    c[2] = static_cast<SampleType>(replacements.b2);
+    c[3] = static_cast<SampleType>(replacements.a1);
+    c[4] = static_cast<SampleType>(replacements.a2);
+}
 
-            buffer.clear();
-        }
-    }
+// The realtime filters at one precision: the bank, and the 2x and 4x
+// oversamplers it runs inside. Everything is allocated in prepare().
+template<typename SampleType>
+struct RealtimeFilters
+{
+    FilterBank<SampleType> filterBank;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 2> oversamplers;
 
-    bool push(const T& t)
+    // What the oversamplers were initialised for, in host samples
+    size_t maxBlockSize{ 0 };
+
+    void prepare(const juce::dsp::ProcessSpec& spec, int samplesPerBlock)
     {
-        auto write = fifo.write(1);
-        if (write.blockSize1 > 0)
+        using Oversampling = juce::dsp::Oversampling<SampleType>;
+
+        maxBlockSize = static_cast<size_t>(samplesPerBlock);
+
+        for (size_t i = 0; i < oversamplers.size(); ++i)
         {
-            buffers[write.startIndex1] = t;
-            return true;
+            oversamplers[i] = std::make_unique<Oversampling>(spec.numChannels, i + 1,
+                Oversampling::filterHalfBandPolyphaseIIR, true, true);
+
+            oversamplers[i]->initProcessing(static_cast<size_t>(samplesPerBlock));
         }
 
-        return false;
+        filterBank.prepare(spec);
     }
 
-    bool pull(T& t)
+    juce::dsp::Oversampling<SampleType>* getOversampler(int oversamplingFactor) const
     {
-        auto read = fifo.read(1);
-        if (read.blockSize1 > 0)
-        {
-            t = buffers[read.startIndex1];
-            return true;
-        }
+        if (oversamplingFactor == 1)
+            return nullptr;
 
-        return false;
+        return oversamplers[oversamplingFactor == 2 ? 0 : 1].get();
     }
 
-private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo{ Capacity };
-};
+    void reset(int oversamplingFactor)
+    {
+        filterBank.reset();
 
-enum Channel
-{
-    Right,
-    Left
-};
+        if (auto* oversampler = getOversampler(oversamplingFactor))
+            oversampler->reset();
+    }
 
-template<typename BlockType>
-struct SingleChannelSampleFifo
-{
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
+    int getLatencyInSamples(int oversamplingFactor) const
     {
-        prepared.set(false);
+        auto* oversampler = getOversampler(oversamplingFactor);
+        return oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0;
     }
 
-    void update(const BlockType& buffer)
+    void process(const juce::dsp::AudioBlock<SampleType>& block, int oversamplingFactor)
     {
-        jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        auto* oversampler = getOversampler(oversamplingFactor);
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        if (oversampler == nullptr)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            filterBank.process(block);
+            return;
         }
-    }
 
-    bool prepare(int bufferSize)
-    {
-        prepared.set(false);
-        size.set(bufferSize);
-
-        bufferToFill.setSize(1,
-            bufferSize,
-            false,
-            true,
-            true);
-
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
-    }
+        // The oversamplers can't take more than they were initialised for
+        auto numSamples = block.getNumSamples();
 
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
-    bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get(); }
-
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
-private:
-    Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
-
-    void pushNextSampleIntoFifo(float sample)
-    {
-        if (fifoIndex == bufferToFill.getNumSamples())
+        for (size_t start = 0; start < numSamples && maxBlockSize > 0; start += maxBlockSize)
         {
-            auto ok = audioBufferFifo.push(bufferToFill);
-
-            juce::ignoreUnused(ok);
+            auto chunk = block.getSubBlock(start, juce::jmin(maxBlockSize, numSamples - start));
 
-            fifoIndex = 0;
+            filterBank.process(oversampler->processSamplesUp(chunk));
+            oversampler->processSamplesDown(chunk);
         }
-
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
     }
 };
 
-enum Slope 
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48,
-};
-
-struct ChainSettings
-{
-    float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
-    float lowCutFreq{ 0 }, highCutFreq{ 0 };
-
-    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
-};
-
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-
-using Filter = juce::dsp::IIR::Filter<float>;
-
-// A single Filter has a 12 db/Oct slope. We need 4 if we want a max of 48 db/Oct
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-
-enum ChainPositions
-{
-	LowCut,
-	Peak,
-	HighCut
-};
-
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
-
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& cutCoefficients)
-{
-	updateCoefficients(chain.template get<Index>().coefficients, cutCoefficients[Index]);
-	chain.template setBypassed<Index>(false);
-}
-
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& leftLowCut,
-	const CoefficientType& cutCoefficients,
-	const Slope cutSlope)
-{
-	leftLowCut.template setBypassed<0>(true);
-	leftLowCut.template setBypassed<1>(true);
-	leftLowCut.template setBypassed<2>(true);
-	leftLowCut.template setBypassed<3>(true);
-
-	switch (cutSlope)
-	{
-	case Slope_48:
-	{
-		update<3>(leftLowCut, cutCoefficients);
-	}
-	case Slope_36:
-	{
-		update<2>(leftLowCut, cutCoefficients);
-	}
-	case Slope_24:
-	{
-		update<1>(leftLowCut, cutCoefficients);
-	}
-	case Slope_12:
-	{
-		update<0>(leftLowCut, cutCoefficients);
-	}
-	}
-}
-
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-	return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-		sampleRate,
-		2 * (chainSettings.lowCutSlope + 1));
-}
-
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-	return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-		sampleRate,
-		2 * (chainSettings.highCutSlope + 1));
-}
-
 //==============================================================================
 /**
 */
@@ -225,6 +128,7 @@ class SimpleEQAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -241,6 +145,11 @@ public:
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+    // Hosts that run at 64 bits get the whole chain in double, without the
+    // conversion copies through float
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -264,19 +173,167 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    // How many parameters the binary state holds: the 10 of the first version,
+    // then the type of band 1 and the 4 parameters of every other band
+    static constexpr int numStateParameters = 10 + 1 + 4 * (numParametricBands - 1);
+
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
 
+    // Spectra of the input and output, read by the editor
+    SpectrumAnalyzer analyzer;
+
+    // The editor draws from the engine's snapshots
+    CoefficientEngine& getCoefficientEngine() { return coefficientEngine; }
+
+    // What each block cost, read by the editor's DSP load overlay
+    BlockStatsRing blockStats;
+
 private:
+    ParameterBindings parameters{ apvts };
+
+    // Saved and restored by getStateInformation / setStateInformation
+    std::array<juce::RangedAudioParameter*, numStateParameters> stateParameters;
+
+    void resolveStateParameters();
+
+    // Sessions saved before the binary format hold the whole APVTS tree
+    void setLegacyStateInformation(const void* data, int sizeInBytes);
+
+    // Every channel shares the same coefficients, so they are filtered together
+    // in SIMD-width groups sized from the bus layout in prepareToPlay. Only the
+    // set matching the host's processing precision is prepared and updated.
+    RealtimeFilters<float> floatFilters;
+    RealtimeFilters<double> doubleFilters;
+
+    template<typename SampleType>
+    RealtimeFilters<SampleType>& getRealtimeFilters()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleFilters;
+        else
+            return floatFilters;
+    }
+
+    // Calls fn with whichever of the two is in use
+    template<typename Fn>
+    void withRealtimeFilters(Fn&& fn)
+    {
+        if (isUsingDoublePrecision())
+            fn(doubleFilters);
+        else
+            fn(floatFilters);
+    }
+
+    // Switching between 1x, 2x and 4x never allocates. The factor in use
+    // follows the published coefficients.
+    int oversamplingFactor{ 1 };
 
-    MonoChain leftChain, rightChain;
+    void setOversamplingFactor(int newFactor);
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilter(const ChainSettings& chainSettings);
-    void updateHighCutFilter(const ChainSettings& chainSettings);
+    // Latency changes made on the audio thread are only stored there. Some
+    // wrappers call into the host from setLatencySamples, so the message
+    // thread reports them.
+    std::atomic<int> pendingLatency{ 0 };
+
+    void reportLatency(int latencyInSamples);
+    void handleAsyncUpdate() override;
+
+    CoefficientEngine coefficientEngine{ apvts };
+
+    // Designs at the targets were usually made by now, by the engine or by
+    // another instance at the same rate. The audio thread only looks them up.
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+
+    // Only used while the "Smoothing" parameter is on. Designs happen on the
+    // audio thread then, once per sub-block, with the allocation-free functions.
+    ChainSmoother smoother;
+    ChainCoefficients smoothedCoefficients;
+    int previousSubBlockSize{ 0 };
+
+    // Every realtime block is filtered in sub-blocks, at most this long when
+    // smoothing is off, and as long as the smoothing steps when it is on
+    static constexpr int maxSubBlockSize = 256;
+    SubBlockScheduler scheduler;
+
+    int getSmoothingSubBlockSize() const;
+    void updateSmoothedFilters(int numSamples);
+
+    template<typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    template<typename SampleType>
+    void processFilters(juce::AudioBuffer<SampleType>& buffer);
+
+    // Idle tracks: once the input has been silent for longer than the tail and
+    // the filter state has died away, blocks are zeroed instead of filtered
+    static constexpr double silenceThreshold = 1.0e-6;
+    juce::int64 silentSamples{ 0 };
+    bool isSuspended{ false };
+
+    template<typename SampleType>
+    bool canSkipFilters(const juce::AudioBuffer<SampleType>& buffer);
+
+    template<typename SampleType>
+    bool areFiltersQuiet() const;
+
+    // In host samples, for the mode in use
+    int getTailLengthInSamples(bool linearPhase) const;
+
+    void updateBandFilter(int index, const BandCoefficients& bandCoefficients);
+    void updateLowCutFilter(const CutCoefficients& lowCutCoefficients);
+    void updateHighCutFilter(const CutCoefficients& highCutCoefficients);
 
     void updateFilters();
 
+    // Reset at the start of each block: the time spent in the update* functions,
+    // and how many sets they designed themselves
+    juce::int64 updateTicks{ 0 };
+    juce::uint32 audioThreadRedesigns{ 0 };
+    juce::uint32 lastEngineRedesigns{ 0 };
+
+    // Offline renders (isNonRealtime) switch to this engine instead: double
+    // precision, always 4x oversampled and with the coefficients following the
+    // automation sample by sample. Everything is allocated in prepareToPlay.
+    static constexpr int highQualityOversamplingFactor = 4;
+
+    FilterBank<double> highQualityFilterBank;
+    std::unique_ptr<juce::dsp::Oversampling<double>> highQualityOversampler;
+
+    // Float blocks are converted through here, double ones are processed in place
+    juce::AudioBuffer<double> highQualityBuffer;
+    ChainSmoother highQualitySmoother;
+    ChainSettings highQualitySettings;
+    ChainCoefficients highQualityCoefficients;
+    bool wasNonRealtime{ false };
+
+    // The "Linear Phase" mode replaces both engines above when it is on
+    LinearPhaseEngine linearPhaseEngine{ apvts };
+    bool wasLinearPhase{ false };
+
+    // The convolution only runs in float, so double blocks go through here
+    juce::AudioBuffer<float> linearPhaseBuffer;
+
+    void setLinearPhase(bool linearPhase);
+
+    void setRenderMode(bool nonRealtime);
+    int getLatencyForRenderMode(bool nonRealtime) const;
+    void updateHighQualityFilters(const ChainSettings& chainSettings, bool forceUpdate);
+
+    template<typename SampleType>
+    void processHighQuality(juce::AudioBuffer<SampleType>& buffer);
+
+    // At most preparedBlockSize samples
+    template<typename SampleType>
+    void processHighQualityChunk(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+
+    // The samplesPerBlock of prepareToPlay: longer host blocks are processed in
+    // pieces of this size wherever a buffer was sized from it
+    int preparedBlockSize{ 0 };
+
+    // Tools/SimpleEQBenchmark times updateFilters() on its own
+    friend struct ProcessorBenchmark;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessor)
 };
@@ -0,0 +1,341 @@
+/*
+  ==============================================================================
+
+    SIMDChain.cpp
+
+  ==============================================================================
+*/
+
+#include "SIMDChain.h"
+
+//==============================================================================
+template<typename SampleType>
+bool SIMDChain<SampleType>::StageFade::setBypassed(bool shouldBeBypassed, int fadeLengthInSamples)
+{
+    auto newTarget = shouldBeBypassed ? 0.f : 1.f;
+
+    if (newTarget == target)
+        return false;
+
+    auto wasBypassed = isBypassed();
+    target = newTarget;
+
+    if (fadeLengthInSamples <= 0)
+    {
+        mix = target;
+        remaining = 0;
+    }
+    else
+    {
+        remaining = fadeLengthInSamples;
+        step = (target - mix) / static_cast<float>(fadeLengthInSamples);
+    }
+
+    return wasBypassed && !shouldBeBypassed;
+}
+
+//==============================================================================
+template<typename SampleType>
+template<int LowCutSections, int HighCutSections>
+void SIMDChain<SampleType>::processVariant(SIMDChain& chain, Vec* frames, size_t numSamples)
+{
+    using Cascade = SOSCascade<SampleType>;
+
+    typename Cascade::template Kernel<LowCutSections> lowCut(chain.lowCut);
+    typename ParametricBands<SampleType>::Kernel bands(chain.bands);
+    typename Cascade::template Kernel<HighCutSections> highCut(chain.highCut);
+
+    for (size_t i = 0; i < numSamples; ++i)
+        frames[i] = highCut.process(bands.process(lowCut.process(frames[i])));
+
+    lowCut.store(chain.lowCut);
+    bands.store(chain.bands);
+    highCut.store(chain.highCut);
+}
+
+template<typename SampleType>
+template<size_t... Indices>
+constexpr std::array<typename SIMDChain<SampleType>::ProcessFunction, sizeof...(Indices)>
+    SIMDChain<SampleType>::makeVariants(std::index_sequence<Indices...>)
+{
+    return { { &processVariant<static_cast<int>(Indices / 5), static_cast<int>(Indices % 5)>... } };
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::updateVariant()
+{
+    static constexpr auto variants = makeVariants(std::make_index_sequence<numVariants>());
+
+    // A band that is fading still runs, so it has to be in the table too
+    juce::uint32 activeBands = 0;
+
+    for (int band = 0; band < numParametricBands; ++band)
+        if (!bandFades[static_cast<size_t>(band)].isBypassed())
+            activeBands |= 1u << band;
+
+    bands.setActiveBands(activeBands);
+
+    auto lowCutSections = lowCutFade.isBypassed() ? 0 : lowCut.getNumSections();
+    auto highCutSections = highCutFade.isBypassed() ? 0 : highCut.getNumSections();
+
+    processFrames = variants[static_cast<size_t>(lowCutSections * 5 + highCutSections)];
+}
+
+template<typename SampleType>
+bool SIMDChain<SampleType>::isBypassed() const noexcept
+{
+    if (!lowCutFade.isBypassed() || !highCutFade.isBypassed())
+        return false;
+
+    for (const auto& fade : bandFades)
+        if (!fade.isBypassed())
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+template<typename SampleType>
+SIMDChain<SampleType>::SIMDChain()
+{
+    // Bands are only switched on by their coefficients
+    for (auto& fade : bandFades)
+        fade.setBypassed(true, 0);
+
+    updateVariant();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels <= getNumLanes());
+
+    maxBlockSize = spec.maximumBlockSize;
+    fadeLengthInSamples = juce::roundToInt(spec.sampleRate * 0.01);
+    interleaved = juce::dsp::AudioBlock<Vec>(interleavedData, 1, maxBlockSize);
+
+    juce::FloatVectorOperations::clear(reinterpret_cast<SampleType*>(interleaved.getChannelPointer(0)),
+        static_cast<int>(maxBlockSize * getNumLanes()));
+
+    reset();
+    updateVariant();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::reset()
+{
+    lowCut.reset();
+    bands.reset();
+    highCut.reset();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::setLowCut(const CutCoefficients& lowCutCoefficients)
+{
+    lowCut.setCoefficients(lowCutCoefficients.sections.data(), lowCutCoefficients.slope + 1);
+
+    // The state froze while the stage was skipped, so don't fade that back in
+    if (lowCutFade.setBypassed(lowCutCoefficients.bypassed, fadeLengthInSamples))
+        lowCut.reset();
+
+    updateVariant();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::setBand(int index, const BandCoefficients& bandCoefficients)
+{
+    jassert(index >= 0 && index < numParametricBands);
+
+    bands.setCoefficients(index, bandCoefficients.section);
+
+    if (bandFades[static_cast<size_t>(index)].setBypassed(bandCoefficients.bypassed, fadeLengthInSamples))
+        bands.reset(index);
+
+    updateVariant();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::setHighCut(const CutCoefficients& highCutCoefficients)
+{
+    highCut.setCoefficients(highCutCoefficients.sections.data(), highCutCoefficients.slope + 1);
+
+    if (highCutFade.setBypassed(highCutCoefficients.bypassed, fadeLengthInSamples))
+        highCut.reset();
+
+    updateVariant();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::process(const Block& block)
+{
+    if (isBypassed() || maxBlockSize == 0)
+        return;
+
+    // A host may send more than it announced: go through it in pieces that fit
+    // the scratch block
+    auto numSamples = block.getNumSamples();
+
+    for (size_t start = 0; start < numSamples; start += maxBlockSize)
+        processChunk(block.getSubBlock(start, juce::jmin(maxBlockSize, numSamples - start)));
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::processChunk(const Block& block)
+{
+    constexpr auto numLanes = getNumLanes();
+
+    auto numChannels = juce::jmin(block.getNumChannels(), numLanes);
+    auto numSamples = block.getNumSamples();
+
+    auto* frames = interleaved.getChannelPointer(0);
+    auto* samples = reinterpret_cast<SampleType*>(frames);
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* src = block.getChannelPointer(ch);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            samples[i * numLanes + ch] = src[i];
+    }
+
+    auto isFading = lowCutFade.isFading() || highCutFade.isFading()
+        || std::any_of(bandFades.begin(), bandFades.end(), [](const StageFade& fade) { return fade.isFading(); });
+
+    if (isFading)
+        processFramesWithFades(frames, numSamples);
+    else
+        processFrames(*this, frames, numSamples);
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dst = block.getChannelPointer(ch);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            dst[i] = samples[i * numLanes + ch];
+    }
+}
+
+template<typename SampleType>
+SampleType SIMDChain<SampleType>::getStateMagnitude() const noexcept
+{
+    // Bypassed stages are frozen, so only the ones that run count
+    auto magnitude = bands.getStateMagnitude();
+
+    if (!lowCutFade.isBypassed())
+        magnitude = juce::jmax(magnitude, lowCut.getStateMagnitude());
+
+    if (!highCutFade.isBypassed())
+        magnitude = juce::jmax(magnitude, highCut.getStateMagnitude());
+
+    return magnitude;
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::processFramesWithFades(Vec* frames, size_t numSamples) noexcept
+{
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto x = frames[i];
+
+        if (!lowCutFade.isBypassed())
+            x = lowCutFade.process(x, lowCut.processSample(x));
+
+        for (int band = 0; band < numParametricBands; ++band)
+        {
+            auto& fade = bandFades[static_cast<size_t>(band)];
+
+            if (!fade.isBypassed())
+                x = fade.process(x, bands.processSample(band, x));
+        }
+
+        if (!highCutFade.isBypassed())
+            x = highCutFade.process(x, highCut.processSample(x));
+
+        frames[i] = x;
+    }
+
+    // A stage that finished fading out can now drop out of the kernel
+    updateVariant();
+}
+
+//==============================================================================
+template<typename SampleType>
+void FilterBank<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    constexpr auto numLanes = SIMDChain<SampleType>::getNumLanes();
+
+    numChannels = spec.numChannels;
+    chains.resize((numChannels + numLanes - 1) / numLanes);
+
+    for (size_t group = 0; group < chains.size(); ++group)
+    {
+        auto groupSpec = spec;
+        groupSpec.numChannels = static_cast<juce::uint32>(juce::jmin(numLanes, numChannels - group * numLanes));
+
+        chains[group].prepare(groupSpec);
+    }
+}
+
+template<typename SampleType>
+void FilterBank<SampleType>::reset()
+{
+    for (auto& chain : chains)
+        chain.reset();
+}
+
+template<typename SampleType>
+void FilterBank<SampleType>::setLowCut(const CutCoefficients& lowCutCoefficients)
+{
+    for (auto& chain : chains)
+        chain.setLowCut(lowCutCoefficients);
+}
+
+template<typename SampleType>
+void FilterBank<SampleType>::setBand(int index, const BandCoefficients& bandCoefficients)
+{
+    for (auto& chain : chains)
+        chain.setBand(index, bandCoefficients);
+}
+
+template<typename SampleType>
+void FilterBank<SampleType>::setHighCut(const CutCoefficients& highCutCoefficients)
+{
+    for (auto& chain : chains)
+        chain.setHighCut(highCutCoefficients);
+}
+
+template<typename SampleType>
+void FilterBank<SampleType>::process(const Block& block)
+{
+    constexpr auto numLanes = SIMDChain<SampleType>::getNumLanes();
+
+    jassert(block.getNumChannels() <= numChannels);
+    auto numChannelsToProcess = juce::jmin(block.getNumChannels(), numChannels);
+
+    for (size_t group = 0; group * numLanes < numChannelsToProcess; ++group)
+    {
+        auto firstChannel = group * numLanes;
+        auto groupBlock = block.getSubsetChannelBlock(firstChannel,
+            juce::jmin(numLanes, numChannelsToProcess - firstChannel));
+
+        chains[group].process(groupBlock);
+    }
+}
+
+template<typename SampleType>
+SampleType FilterBank<SampleType>::getStateMagnitude() const noexcept
+{
+    SampleType magnitude = 0;
+
+    for (const auto& chain : chains)
+        magnitude = juce::jmax(magnitude, chain.getStateMagnitude());
+
+    return magnitude;
+}
+
+//==============================================================================
+template class SIMDChain<float>;
+template class SIMDChain<double>;
+
+template class FilterBank<float>;
+template class FilterBank<double>;
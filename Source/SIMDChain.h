@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    SIMDChain.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+#include "SOSCascade.h"
+#include "ParametricBands.h"
+
+#include <utility>
+
+/**
+    The LowCut -> parametric bands -> HighCut cascade of a MonoChain, but with one
+    channel per SIMD lane, so left and right are filtered together in a single pass.
+
+    All channels always share the same coefficients. The samples are interleaved
+    into an aligned scratch block, each stage runs over it as an SOSCascade in
+    transposed direct form II (like IIR::Filter), then it is written back.
+
+    A stage or band whose coefficients are marked bypassed is skipped entirely.
+    Going in and out of bypass is crossfaded over a few milliseconds so it
+    doesn't click.
+
+    Every combination of active low cut and high cut sections has its own
+    compile-time instantiated kernel that runs the whole chain in one pass, with
+    the active parametric bands as a loop over their compacted table in between.
+    The matching kernel is looked up only when a slope or bypass state changes.
+
+    Instantiated for float (the realtime engine) and double (the offline one).
+*/
+template<typename SampleType>
+class SIMDChain
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    using Block = juce::dsp::AudioBlock<SampleType>;
+
+    // The number of channels a single chain can process
+    static constexpr size_t getNumLanes() { return Vec::size(); }
+
+    SIMDChain();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setLowCut(const CutCoefficients& lowCutCoefficients);
+    void setBand(int index, const BandCoefficients& bandCoefficients);
+    void setHighCut(const CutCoefficients& highCutCoefficients);
+
+    // Processes up to getNumLanes() channels in place, blocks of any length
+    void process(const Block& block);
+
+    SampleType getStateMagnitude() const noexcept;
+
+private:
+    // Linear dry/wet mix used while a stage goes in or out of bypass
+    struct StageFade
+    {
+        // Returns true if the stage was fully bypassed and now starts fading in
+        bool setBypassed(bool shouldBeBypassed, int fadeLengthInSamples);
+
+        bool isBypassed() const noexcept { return remaining == 0 && mix == 0.f; }
+        bool isFading() const noexcept { return remaining > 0; }
+
+        Vec process(Vec dry, Vec wet) noexcept
+        {
+            if (remaining == 0)
+                return mix == 0.f ? dry : wet;
+
+            auto y = dry + (wet - dry) * Vec::expand(static_cast<SampleType>(mix));
+
+            if (--remaining == 0)
+                mix = target;
+            else
+                mix += step;
+
+            return y;
+        }
+
+        float mix{ 1.f }, target{ 1.f }, step{ 0.f };
+        int remaining{ 0 };
+    };
+
+    using ProcessFunction = void (*)(SIMDChain&, Vec*, size_t);
+
+    // 0-4 low cut sections by 0-4 high cut sections
+    static constexpr int numVariants = 5 * 5;
+
+    template<int LowCutSections, int HighCutSections>
+    static void processVariant(SIMDChain& chain, Vec* frames, size_t numSamples);
+
+    template<size_t... Indices>
+    static constexpr std::array<ProcessFunction, sizeof...(Indices)> makeVariants(std::index_sequence<Indices...>);
+
+    void updateVariant();
+    bool isBypassed() const noexcept;
+
+    // At most maxBlockSize samples
+    void processChunk(const Block& block);
+
+    void processFramesWithFades(Vec* frames, size_t numSamples) noexcept;
+
+    ProcessFunction processFrames{ nullptr };
+
+    SOSCascade<SampleType> lowCut, highCut;
+    ParametricBands<SampleType> bands;
+
+    StageFade lowCutFade, highCutFade;
+    std::array<StageFade, numParametricBands> bandFades;
+    int fadeLengthInSamples{ 0 };
+
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<Vec> interleaved;
+    size_t maxBlockSize{ 0 };
+};
+
+//==============================================================================
+/**
+    Runs any number of channels through the chain, in groups of
+    SIMDChain::getNumLanes() channels, so cost scales with the number of groups
+    rather than with the number of channels.
+*/
+template<typename SampleType>
+class FilterBank
+{
+public:
+    using Block = juce::dsp::AudioBlock<SampleType>;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setLowCut(const CutCoefficients& lowCutCoefficients);
+    void setBand(int index, const BandCoefficients& bandCoefficients);
+    void setHighCut(const CutCoefficients& highCutCoefficients);
+
+    void process(const Block& block);
+
+    // The largest filter state of any channel, which is ~0 once the tail died away
+    SampleType getStateMagnitude() const noexcept;
+
+private:
+    std::vector<SIMDChain<SampleType>> chains;
+    size_t numChannels{ 0 };
+};
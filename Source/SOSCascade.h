@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    SOSCascade.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+
+/**
+    Up to 4 second order sections in series, e.g. the Butterworth designs of a
+    cut filter, with one channel per SIMD lane.
+
+    Coefficients and state live in contiguous arrays. The Kernel is templated on
+    the number of sections, so every active section runs per sample with its
+    state held in registers and no per-section branch or bypass check.
+*/
+template<typename SampleType>
+class SOSCascade
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int maxNumSections = 4;
+
+    SOSCascade()
+    {
+        // Start out as pass-through sections
+        std::array<BiquadCoefficients, maxNumSections> identity;
+        setCoefficients(identity.data(), maxNumSections);
+        numSections = 1;
+
+        reset();
+    }
+
+    void setCoefficients(const BiquadCoefficients* sections, int numSectionsToUse)
+    {
+        jassert(numSectionsToUse > 0 && numSectionsToUse <= maxNumSections);
+        numSections = numSectionsToUse;
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            b0[k] = Vec::expand(static_cast<SampleType>(sections[k].b0));
+            b1[k] = Vec::expand(static_cast<SampleType>(sections[k].b1));
+            b2[k] = Vec::expand(static_cast<SampleType>(sections[k].b2));
+            a1[k] = Vec::expand(static_cast<SampleType>(sections[k].a1));
+            a2[k] = Vec::expand(static_cast<SampleType>(sections[k].a2));
+        }
+    }
+
+    void reset()
+    {
+        for (int k = 0; k < maxNumSections; ++k)
+        {
+            s1[k] = Vec::expand(SampleType(0));
+            s2[k] = Vec::expand(SampleType(0));
+        }
+    }
+
+    int getNumSections() const noexcept { return numSections; }
+
+    // The largest state value of any section and lane, to tell when a tail has died away
+    SampleType getStateMagnitude() const noexcept
+    {
+        auto magnitude = Vec::expand(SampleType(0));
+
+        for (int k = 0; k < numSections; ++k)
+            magnitude = Vec::max(magnitude, Vec::max(Vec::abs(s1[k]), Vec::abs(s2[k])));
+
+        SampleType result = 0;
+
+        for (size_t lane = 0; lane < Vec::size(); ++lane)
+            result = juce::jmax(result, magnitude.get(lane));
+
+        return result;
+    }
+
+    /** The cascade with its coefficients and state copied into locals, for a
+        compile-time number of sections. A kernel with 0 sections passes the
+        signal through, which lets bypassed stages compile away.
+        Call store() when done so the state carries over to the next block.
+    */
+    template<int NumSections>
+    struct Kernel
+    {
+        static_assert(NumSections >= 0 && NumSections <= maxNumSections, "Unsupported number of sections");
+
+        explicit Kernel(const SOSCascade& cascade) noexcept
+        {
+            jassert(NumSections == 0 || NumSections == cascade.numSections);
+
+            for (int k = 0; k < NumSections; ++k)
+            {
+                c0[k] = cascade.b0[k]; c1[k] = cascade.b1[k]; c2[k] = cascade.b2[k];
+                d1[k] = cascade.a1[k]; d2[k] = cascade.a2[k];
+                z1[k] = cascade.s1[k]; z2[k] = cascade.s2[k];
+            }
+        }
+
+        Vec process(Vec x) noexcept
+        {
+            for (int k = 0; k < NumSections; ++k)
+            {
+                auto y = c0[k] * x + z1[k];
+                z1[k] = c1[k] * x - d1[k] * y + z2[k];
+                z2[k] = c2[k] * x - d2[k] * y;
+                x = y;
+            }
+
+            return x;
+        }
+
+        void store(SOSCascade& cascade) const noexcept
+        {
+            for (int k = 0; k < NumSections; ++k)
+            {
+                cascade.s1[k] = z1[k];
+                cascade.s2[k] = z2[k];
+            }
+        }
+
+        std::array<Vec, NumSections> c0, c1, c2, d1, d2;
+        std::array<Vec, NumSections> z1, z2;
+    };
+
+    // One frame at a time, for the rare paths that need to mix per sample
+    Vec processSample(Vec x) noexcept
+    {
+        for (int k = 0; k < numSections; ++k)
+        {
+            auto y = b0[k] * x + s1[k];
+            s1[k] = b1[k] * x - a1[k] * y + s2[k];
+            s2[k] = b2[k] * x - a2[k] * y;
+            x = y;
+        }
+
+        return x;
+    }
+
+private:
+    std::array<Vec, maxNumSections> b0, b1, b2, a1, a2;
+    std::array<Vec, maxNumSections> s1, s2;
+
+    int numSections{ 1 };
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+{
+    for (auto& h : history)
+        h.fill(0.f);
+
+    workerThread->addTimeSliceClient(this);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    workerThread->removeTimeSliceClient(this);
+}
+
+void SpectrumAnalyzer::prepare(double sampleRate, int samplesPerBlock)
+{
+    const juce::ScopedLock sl(analysisLock);
+
+    // Room for a few blocks on top of a full FFT frame, in case the worker lags
+    for (auto& fifo : fifos)
+        fifo.prepare(fftSize + samplesPerBlock * 4);
+
+    for (auto& h : history)
+        h.fill(0.f);
+
+    current.sampleRate = sampleRate;
+}
+
+template<typename SampleType>
+void SpectrumAnalyzer::pushPreEQ(const juce::AudioBuffer<SampleType>& buffer)
+{
+    if (!isEnabled())
+        return;
+
+    fifos[PreLeft].update(buffer);
+    fifos[PreRight].update(buffer);
+}
+
+template<typename SampleType>
+void SpectrumAnalyzer::pushPostEQ(const juce::AudioBuffer<SampleType>& buffer)
+{
+    if (!isEnabled())
+        return;
+
+    fifos[PostLeft].update(buffer);
+    fifos[PostRight].update(buffer);
+}
+
+template void SpectrumAnalyzer::pushPreEQ<float>(const juce::AudioBuffer<float>&);
+template void SpectrumAnalyzer::pushPreEQ<double>(const juce::AudioBuffer<double>&);
+template void SpectrumAnalyzer::pushPostEQ<float>(const juce::AudioBuffer<float>&);
+template void SpectrumAnalyzer::pushPostEQ<double>(const juce::AudioBuffer<double>&);
+
+int SpectrumAnalyzer::useTimeSlice()
+{
+    if (!isEnabled())
+        return 50;
+
+    const juce::ScopedLock sl(analysisLock);
+
+    bool analysed = false;
+
+    for (int spectrum = 0; spectrum < NumSpectra; ++spectrum)
+    {
+        auto& h = history[spectrum];
+
+        while (fifos[spectrum].isPrepared() && fifos[spectrum].getNumAvailable() >= hopSize)
+        {
+            // Slide the window along by one hop
+            std::copy(h.begin() + hopSize, h.end(), h.begin());
+            fifos[spectrum].pull(h.data() + fftSize - hopSize, hopSize);
+
+            analyse(spectrum);
+            analysed = true;
+        }
+    }
+
+    if (!analysed)
+        return 10;
+
+    frames.getWriteBuffer() = current;
+    frames.publish();
+
+    sendChangeMessage();
+
+    return 5;
+}
+
+void SpectrumAnalyzer::analyse(int spectrum)
+{
+    std::copy(history[spectrum].begin(), history[spectrum].end(), fftData.begin());
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.f);
+
+    window.multiplyWithWindowingTable(fftData.data(), static_cast<size_t>(fftSize));
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    auto& magnitudes = current.magnitudesInDecibels[spectrum];
+
+    for (int bin = 0; bin < numBins; ++bin)
+        magnitudes[bin] = juce::Decibels::gainToDecibels(fftData[bin] / static_cast<float>(numBins), minusInfinityDb);
+}
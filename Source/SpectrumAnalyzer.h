@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+#include "WorkerThread.h"
+
+#include <array>
+#include <atomic>
+
+// Used as the channel index into the buffer
+enum Channel
+{
+    Left,
+    Right
+};
+
+/**
+    Lock-free ring of samples from one channel of the processed audio.
+    The audio thread copies whole blocks in (at most two memcpys), the analyzer
+    copies them out on the worker. When the ring is full new samples are dropped.
+*/
+struct SingleChannelSampleFifo
+{
+    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
+    {
+        prepared.set(false);
+    }
+
+    template<typename SampleType>
+    void update(const juce::AudioBuffer<SampleType>& buffer)
+    {
+        if (!prepared.get() || buffer.getNumChannels() <= channelToUse)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(buffer.getNumSamples(), start1, size1, start2, size2);
+
+        auto* src = buffer.getReadPointer(channelToUse);
+        auto* dst = samples.getWritePointer(0);
+
+        if (size1 > 0)
+            copy(dst + start1, src, size1);
+
+        if (size2 > 0)
+            copy(dst + start2, src + size1, size2);
+
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    // Copies out exactly numSamples, or nothing if that many aren't there yet
+    bool pull(float* dest, int numSamples)
+    {
+        if (fifo.getNumReady() < numSamples)
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(numSamples, start1, size1, start2, size2);
+
+        auto* src = samples.getReadPointer(0);
+
+        if (size1 > 0)
+            juce::FloatVectorOperations::copy(dest, src + start1, size1);
+
+        if (size2 > 0)
+            juce::FloatVectorOperations::copy(dest + size1, src + start2, size2);
+
+        fifo.finishedRead(size1 + size2);
+        return true;
+    }
+
+    void prepare(int capacity)
+    {
+        prepared.set(false);
+
+        samples.setSize(1, capacity, false, true, true);
+        samples.clear();
+
+        fifo.setTotalSize(capacity);
+        fifo.reset();
+
+        prepared.set(true);
+    }
+
+    int getNumAvailable() const { return fifo.getNumReady(); }
+    bool isPrepared() const { return prepared.get(); }
+
+private:
+    // The analysis is in float whatever the host runs at
+    static void copy(float* dest, const float* src, int numSamples)
+    {
+        juce::FloatVectorOperations::copy(dest, src, numSamples);
+    }
+
+    static void copy(float* dest, const double* src, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = static_cast<float>(src[i]);
+    }
+
+    Channel channelToUse;
+    juce::AudioBuffer<float> samples;
+    juce::AbstractFifo fifo{ 1 };
+    juce::Atomic<bool> prepared = false;
+};
+
+//==============================================================================
+/**
+    Left/right spectra of the signal before and after the EQ.
+
+    The processor pushes blocks from the audio thread, the FFTs run on the shared
+    WorkerThread, and finished frames of magnitudes in dB are handed to the editor
+    through a TripleBuffer. Nothing happens unless an editor enabled it.
+    A change message is sent whenever a frame is published.
+*/
+class SpectrumAnalyzer : public juce::ChangeBroadcaster,
+    private juce::TimeSliceClient
+{
+public:
+    enum Spectrum
+    {
+        PreLeft,
+        PreRight,
+        PostLeft,
+        PostRight,
+        NumSpectra
+    };
+
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2;
+
+    // Lowest level a bin can report
+    static constexpr float minusInfinityDb = -96.f;
+
+    struct Frame
+    {
+        Frame()
+        {
+            for (auto& spectrum : magnitudesInDecibels)
+                spectrum.fill(minusInfinityDb);
+        }
+
+        std::array<std::array<float, numBins>, NumSpectra> magnitudesInDecibels;
+        double sampleRate{ 44100.0 };
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    void prepare(double sampleRate, int samplesPerBlock);
+
+    // Called by the editor while it wants frames
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Audio thread
+    template<typename SampleType>
+    void pushPreEQ(const juce::AudioBuffer<SampleType>& buffer);
+
+    template<typename SampleType>
+    void pushPostEQ(const juce::AudioBuffer<SampleType>& buffer);
+
+    // Message thread: returns true if a new frame arrived since the last call
+    bool acquire() { return frames.acquire(); }
+    const Frame& getFrame() const { return frames.getReadBuffer(); }
+
+private:
+    int useTimeSlice() override;
+    void analyse(int spectrum);
+
+    static constexpr int hopSize = fftSize / 2;
+
+    std::array<SingleChannelSampleFifo, NumSpectra> fifos{ { Channel::Left, Channel::Right, Channel::Left, Channel::Right } };
+
+    // Worker only, guarded against prepare() by the lock
+    juce::CriticalSection analysisLock;
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ static_cast<size_t>(fftSize), juce::dsp::WindowingFunction<float>::blackmanHarris };
+    std::array<std::array<float, fftSize>, NumSpectra> history;
+    std::array<float, fftSize * 2> fftData;
+    Frame current;
+
+    TripleBuffer<Frame> frames;
+
+    std::atomic<bool> enabled{ false };
+
+    juce::SharedResourcePointer<WorkerThread> workerThread;
+};
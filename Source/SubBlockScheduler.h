@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    SubBlockScheduler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+/**
+    Cuts a host block into the sub-blocks the filters are updated on.
+
+    A sub-block is never longer than the maximum size, and one always starts at
+    each change point marked for the block. So the coefficients follow the
+    parameters on a grid that doesn't depend on the host's buffer size, and the
+    work per host block stays proportional to its length.
+
+    Change points can also be marked while the block is being processed, for
+    any offset after the sub-block that is running. They are cleared at the end
+    of each block. Nothing here allocates.
+*/
+struct SubBlockScheduler
+{
+    static constexpr int maxNumChangePoints = 16;
+
+    void setMaximumSubBlockSize(int newMaximumSubBlockSize)
+    {
+        jassert(newMaximumSubBlockSize > 0);
+        maximumSubBlockSize = juce::jmax(1, newMaximumSubBlockSize);
+    }
+
+    int getMaximumSubBlockSize() const noexcept { return maximumSubBlockSize; }
+
+    // Offsets past the end of the block are ignored, as are any beyond the
+    // first maxNumChangePoints: the maximum size still bounds those sub-blocks
+    void addChangePoint(int sampleOffset, int numSamplesInBlock)
+    {
+        if (sampleOffset <= 0 || sampleOffset >= numSamplesInBlock || numChangePoints == maxNumChangePoints)
+            return;
+
+        auto* first = changePoints.data();
+        auto* last = first + numChangePoints;
+        auto* position = std::lower_bound(first, last, sampleOffset);
+
+        if (position != last && *position == sampleOffset)
+            return;
+
+        std::move_backward(position, last, last + 1);
+        *position = sampleOffset;
+        ++numChangePoints;
+    }
+
+    // Calls fn(startSample, numSamples) for each sub-block of the block, in order
+    template<typename Fn>
+    void process(int numSamples, Fn&& fn)
+    {
+        for (int start = 0; start < numSamples;)
+        {
+            auto end = juce::jmin(numSamples, start + maximumSubBlockSize);
+
+            for (int i = 0; i < numChangePoints; ++i)
+            {
+                if (changePoints[static_cast<size_t>(i)] > start)
+                {
+                    end = juce::jmin(end, changePoints[static_cast<size_t>(i)]);
+                    break;
+                }
+            }
+
+            fn(start, end - start);
+            start = end;
+        }
+
+        numChangePoints = 0;
+    }
+
+private:
+    // Sorted, without duplicates
+    std::array<int, maxNumChangePoints> changePoints{};
+    int numChangePoints{ 0 };
+
+    int maximumSubBlockSize{ 256 };
+};
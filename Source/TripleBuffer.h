@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/**
+    Wait-free handoff of whole objects from one writer thread to one reader thread.
+
+    The writer fills getWriteBuffer() and calls publish(), the reader calls acquire()
+    and then uses getReadBuffer(). Neither side ever blocks or allocates, and the
+    reader always sees the most recently published object.
+*/
+template<typename T>
+class TripleBuffer
+{
+public:
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    void publish()
+    {
+        auto previous = middle.exchange(writeIndex | newDataBit, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // Returns true if a new object was published since the last acquire
+    bool acquire()
+    {
+        if ((middle.load(std::memory_order_relaxed) & newDataBit) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataBit = 4;
+
+    std::array<T, 3> buffers;
+    int writeIndex{ 0 }, readIndex{ 1 };
+    std::atomic<int> middle{ 2 };
+};
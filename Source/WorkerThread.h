@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+    WorkerThread.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// A single background thread shared by every plugin instance in the process,
+// for work that has to stay off the audio thread.
+// Hold it with a juce::SharedResourcePointer<WorkerThread>.
+struct WorkerThread : juce::TimeSliceThread
+{
+    WorkerThread() : juce::TimeSliceThread("SimpleEQ Worker")
+    {
+        startThread();
+    }
+
+    ~WorkerThread() override
+    {
+        stopThread(1000);
+    }
+};
@@ -0,0 +1,326 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Times the SimpleEQ processor and editor paint paths without a host and
+    prints the results as JSON.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/PluginEditor.h"
+
+#include <algorithm>
+#include <numeric>
+
+//==============================================================================
+struct Timings
+{
+    std::vector<double> nanoseconds;
+    std::vector<juce::int64> allocations;
+
+    void add(double ns, juce::int64 numAllocs)
+    {
+        nanoseconds.push_back(ns);
+        allocations.push_back(numAllocs);
+    }
+
+    juce::var toVar(int samplesPerRun) const
+    {
+        auto sorted = nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto percentile = [&sorted](double p)
+        {
+            if (sorted.empty())
+                return 0.0;
+
+            auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[index];
+        };
+
+        auto total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+        auto totalAllocations = std::accumulate(allocations.begin(), allocations.end(), juce::int64(0));
+        auto maxAllocations = allocations.empty() ? juce::int64(0) : *std::max_element(allocations.begin(), allocations.end());
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("runs", static_cast<int>(sorted.size()));
+
+        if (samplesPerRun > 0 && !sorted.empty())
+            result->setProperty("nsPerSample", total / (static_cast<double>(sorted.size()) * samplesPerRun));
+
+        result->setProperty("p50Ns", percentile(0.5));
+        result->setProperty("p90Ns", percentile(0.9));
+        result->setProperty("p99Ns", percentile(0.99));
+        result->setProperty("maxNs", sorted.empty() ? 0.0 : sorted.back());
+        result->setProperty("allocationsPerRun", sorted.empty() ? 0.0 : static_cast<double>(totalAllocations) / static_cast<double>(sorted.size()));
+        result->setProperty("maxAllocationsPerRun", maxAllocations);
+
+        return juce::var(result);
+    }
+};
+
+static double ticksToNanoseconds(juce::int64 ticks)
+{
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9;
+}
+
+//==============================================================================
+enum class Automation
+{
+    None,
+    PeakSweep,
+    CutSweep,
+    SmoothedPeakSweep
+};
+
+static const char* getName(Automation automation)
+{
+    switch (automation)
+    {
+        case Automation::None:              return "none";
+        case Automation::PeakSweep:         return "peakSweep";
+        case Automation::CutSweep:          return "cutSweep";
+        case Automation::SmoothedPeakSweep: return "smoothedPeakSweep";
+    }
+
+    return "";
+}
+
+struct ProcessorBenchmark
+{
+    static void setParameter(SimpleEQAudioProcessor& processor, const char* parameterID, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(parameterID);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    static void setUp(SimpleEQAudioProcessor& processor, Slope lowCutSlope, Slope highCutSlope, Automation automation)
+    {
+        setParameter(processor, ParamIDs::lowCutFreq, 80.f);
+        setParameter(processor, ParamIDs::highCutFreq, 12000.f);
+        setParameter(processor, ParamIDs::peakFreq, 1000.f);
+        setParameter(processor, ParamIDs::peakGain, 6.f);
+        setParameter(processor, ParamIDs::peakQuality, 1.f);
+        setParameter(processor, ParamIDs::lowCutSlope, static_cast<float>(lowCutSlope));
+        setParameter(processor, ParamIDs::highCutSlope, static_cast<float>(highCutSlope));
+        setParameter(processor, ParamIDs::smoothing, automation == Automation::SmoothedPeakSweep ? 2.f : 0.f);
+    }
+
+    static void automate(SimpleEQAudioProcessor& processor, Automation automation, int block, int numBlocks)
+    {
+        auto phase = static_cast<float>(block) / static_cast<float>(juce::jmax(1, numBlocks - 1));
+
+        switch (automation)
+        {
+            case Automation::None:
+                break;
+
+            case Automation::PeakSweep:
+            case Automation::SmoothedPeakSweep:
+                setParameter(processor, ParamIDs::peakFreq, juce::mapToLog10(phase, 20.f, 20000.f));
+                setParameter(processor, ParamIDs::peakGain, -24.f + 48.f * phase);
+                break;
+
+            case Automation::CutSweep:
+                setParameter(processor, ParamIDs::lowCutFreq, juce::mapToLog10(phase * 0.5f, 20.f, 20000.f));
+                setParameter(processor, ParamIDs::highCutFreq, juce::mapToLog10(0.5f + phase * 0.5f, 20.f, 20000.f));
+                break;
+        }
+    }
+
+    static juce::var processBlock(double sampleRate, int blockSize, Slope lowCutSlope, Slope highCutSlope, Automation automation)
+    {
+        SimpleEQAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        setUp(processor, lowCutSlope, highCutSlope, automation);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1234);
+
+        // One second of audio, after a short warm up
+        auto numBlocks = juce::jmax(16, static_cast<int>(sampleRate) / blockSize);
+        auto numWarmUpBlocks = juce::jmax(4, numBlocks / 10);
+
+        Timings timings;
+
+        for (int block = -numWarmUpBlocks; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+
+            automate(processor, automation, juce::jmax(0, block), numBlocks);
+
+            ScopedAllocationCounter allocationCounter;
+            auto start = juce::Time::getHighResolutionTicks();
+
+            processor.processBlock(buffer, midi);
+
+            auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+            if (block >= 0)
+                timings.add(ticksToNanoseconds(elapsed), static_cast<juce::int64>(allocationCounter.getCount()));
+        }
+
+        processor.releaseResources();
+
+        auto result = timings.toVar(blockSize);
+        auto* object = result.getDynamicObject();
+        object->setProperty("sampleRate", sampleRate);
+        object->setProperty("blockSize", blockSize);
+        object->setProperty("lowCutSlope", 12 * (lowCutSlope + 1));
+        object->setProperty("highCutSlope", 12 * (highCutSlope + 1));
+        object->setProperty("automation", getName(automation));
+
+        return result;
+    }
+
+    // Applying a new set only: the design itself runs on the worker, and is timed separately
+    static juce::var updateFilters(double sampleRate)
+    {
+        SimpleEQAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(sampleRate, 512);
+        setUp(processor, Slope_48, Slope_48, Automation::PeakSweep);
+        processor.prepareToPlay(sampleRate, 512);
+
+        // Otherwise the worker designs the same dirty bands while we time them
+        processor.coefficientEngine.setUsingWorker(false);
+
+        constexpr int numRuns = 2000;
+        Timings applyTimings, designTimings;
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            automate(processor, Automation::CutSweep, run, numRuns);
+            automate(processor, Automation::PeakSweep, run, numRuns);
+
+            {
+                ScopedAllocationCounter allocationCounter;
+                auto start = juce::Time::getHighResolutionTicks();
+
+                processor.coefficientEngine.update();
+
+                designTimings.add(ticksToNanoseconds(juce::Time::getHighResolutionTicks() - start), static_cast<juce::int64>(allocationCounter.getCount()));
+            }
+
+            {
+                ScopedAllocationCounter allocationCounter;
+                auto start = juce::Time::getHighResolutionTicks();
+
+                processor.updateFilters();
+
+                applyTimings.add(ticksToNanoseconds(juce::Time::getHighResolutionTicks() - start), static_cast<juce::int64>(allocationCounter.getCount()));
+            }
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("design", designTimings.toVar(0));
+        result->setProperty("updateFilters", applyTimings.toVar(0));
+
+        return juce::var(result);
+    }
+
+    static juce::var paintResponseCurve(int width, int height, float scale)
+    {
+        SimpleEQAudioProcessor processor;
+        setUp(processor, Slope_24, Slope_36, Automation::None);
+        processor.prepareToPlay(48000.0, 512);
+
+        ResponseCurveComponent component(processor);
+        component.setSize(width, height);
+
+        juce::Image image(juce::Image::ARGB, juce::roundToInt(width * scale), juce::roundToInt(height * scale), true);
+
+        constexpr int numRuns = 500;
+        Timings timings;
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            juce::Graphics g(image);
+            g.addTransform(juce::AffineTransform::scale(scale));
+
+            ScopedAllocationCounter allocationCounter;
+            auto start = juce::Time::getHighResolutionTicks();
+
+            component.paint(g);
+
+            timings.add(ticksToNanoseconds(juce::Time::getHighResolutionTicks() - start), static_cast<juce::int64>(allocationCounter.getCount()));
+        }
+
+        auto result = timings.toVar(0);
+        auto* object = result.getDynamicObject();
+        object->setProperty("width", width);
+        object->setProperty("height", height);
+        object->setProperty("scale", scale);
+
+        return result;
+    }
+};
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    // --quick runs a reduced matrix, for a smoke test
+    auto quick = args.containsOption("--quick");
+    auto outputPath = args.removeValueForOption("--output");
+
+    std::vector<double> sampleRates{ 44100.0, 48000.0, 96000.0 };
+    std::vector<int> blockSizes{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    std::vector<std::pair<Slope, Slope>> slopes{ { Slope_12, Slope_12 }, { Slope_24, Slope_36 }, { Slope_48, Slope_48 } };
+    std::vector<Automation> automations{ Automation::None, Automation::PeakSweep, Automation::CutSweep, Automation::SmoothedPeakSweep };
+
+    if (quick)
+    {
+        sampleRates = { 48000.0 };
+        blockSizes = { 64, 512 };
+        slopes = { { Slope_48, Slope_48 } };
+    }
+
+    juce::Array<juce::var> processResults, updateResults, paintResults;
+
+    for (auto sampleRate : sampleRates)
+        for (auto blockSize : blockSizes)
+            for (const auto& slope : slopes)
+                for (auto automation : automations)
+                    processResults.add(ProcessorBenchmark::processBlock(sampleRate, blockSize, slope.first, slope.second, automation));
+
+    for (auto sampleRate : sampleRates)
+        updateResults.add(ProcessorBenchmark::updateFilters(sampleRate));
+
+    paintResults.add(ProcessorBenchmark::paintResponseCurve(600, 250, 1.f));
+    paintResults.add(ProcessorBenchmark::paintResponseCurve(600, 250, 2.f));
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("juce", juce::SystemStats::getJUCEVersion());
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("processBlock", processResults);
+    root->setProperty("updateFilters", updateResults);
+    root->setProperty("paintResponseCurve", paintResults);
+
+    auto json = juce::JSON::toString(juce::var(root));
+
+    if (outputPath.isNotEmpty())
+    {
+        if (!juce::File::getCurrentWorkingDirectory().getChildFile(outputPath).replaceWithText(json))
+        {
+            std::cerr << "Can't write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,382 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Renders audio files through the SimpleEQ filter chain, without a host.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/SIMDChain.h"
+
+#include <atomic>
+
+static void printUsage()
+{
+    std::cout << "Usage: SimpleEQRender [options] --output <dir> <file>...\n"
+                 "\n"
+                 "  --lowcut-freq <Hz>       (20)\n"
+                 "  --lowcut-slope <dB/Oct>  12, 24, 36 or 48 (12)\n"
+                 "  --highcut-freq <Hz>      (20000)\n"
+                 "  --highcut-slope <dB/Oct> 12, 24, 36 or 48 (12)\n"
+                 "\n"
+                 "  For each parametric band N, from 1 to 8:\n"
+                 "  --bandN-type <type>      off, peak, lowshelf, highshelf or notch\n"
+                 "                           (peak for band 1, off for the others)\n"
+                 "  --bandN-freq <Hz>        (750, 60, 150, 400, 1500, 3500, 7000, 12000)\n"
+                 "  --bandN-gain <dB>        (0)\n"
+                 "  --bandN-quality <Q>      (1)\n"
+                 "  --peak-freq, --peak-gain and --peak-quality set band 1 too\n"
+                 "\n"
+                 "  --threads <n>            files rendered in parallel (number of cores)\n"
+                 "  --block-size <samples>   size of the chunks read from disk (65536)\n";
+}
+
+// In the order of BandType, as the plugin's "Type" choices
+static const char* const bandTypeNames[] = { "off", "peak", "lowshelf", "highshelf", "notch" };
+
+// Same ranges and defaults as createParameterLayout. Returns false, with the
+// reason in error, for a band type it doesn't know.
+static bool parseChainSettings(juce::ArgumentList& args, ChainSettings& settings, juce::String& error)
+{
+    auto getFloat = [&args](const juce::String& option, float defaultValue, float minimum, float maximum)
+    {
+        auto value = args.removeValueForOption(option);
+        return value.isEmpty() ? defaultValue : juce::jlimit(minimum, maximum, value.getFloatValue());
+    };
+
+    auto getSlope = [&args](const char* option)
+    {
+        auto value = args.removeValueForOption(option);
+        auto dbPerOct = value.isEmpty() ? 12 : value.getIntValue();
+        return static_cast<Slope>(juce::jlimit(0, 3, dbPerOct / 12 - 1));
+    };
+
+    settings.lowCutFreq = getFloat("--lowcut-freq", 20.f, 20.f, 20000.f);
+    settings.lowCutSlope = getSlope("--lowcut-slope");
+    settings.highCutFreq = getFloat("--highcut-freq", 20000.f, 20.f, 20000.f);
+    settings.highCutSlope = getSlope("--highcut-slope");
+
+    for (int i = 0; i < numParametricBands; ++i)
+    {
+        auto& band = settings.bands[static_cast<size_t>(i)];
+        auto prefix = "--band" + juce::String(i + 1) + "-";
+
+        auto typeName = args.removeValueForOption(prefix + "type");
+        band.type = i == 0 ? Band_Peak : Band_Off;
+
+        if (typeName.isNotEmpty())
+        {
+            auto index = juce::StringArray(bandTypeNames, static_cast<int>(std::size(bandTypeNames))).indexOf(typeName, true);
+
+            if (index < 0)
+            {
+                error = "Unknown band type " + typeName;
+                return false;
+            }
+
+            band.type = static_cast<BandType>(index);
+        }
+
+        band.freq = getFloat(prefix + "freq", defaultBandFrequencies[i], 20.f, 20000.f);
+        band.gainInDecibels = getFloat(prefix + "gain", 0.f, -24.f, 24.f);
+        band.quality = getFloat(prefix + "quality", 1.f, 0.1f, 10.f);
+    }
+
+    // The original peak options, for scripts written before the other bands
+    auto& peak = settings.bands[0];
+    peak.freq = getFloat("--peak-freq", peak.freq, 20.f, 20000.f);
+    peak.gainInDecibels = getFloat("--peak-gain", peak.gainInDecibels, -24.f, 24.f);
+    peak.quality = getFloat("--peak-quality", peak.quality, 0.1f, 10.f);
+
+    return true;
+}
+
+// What the plugin's offline render runs at, SimpleEQAudioProcessor::highQualityOversamplingFactor
+constexpr int oversamplingOrder = 2;
+constexpr int oversamplingFactor = 1 << oversamplingOrder;
+
+// The plugin's designs, with the same stages skipped
+static void designFilters(FilterBank<double>& filterBank, const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainCoefficients coefficients;
+
+    designLowCutFilter(coefficients.lowCut, chainSettings, sampleRate);
+    designHighCutFilter(coefficients.highCut, chainSettings, sampleRate);
+
+    filterBank.setLowCut(coefficients.lowCut);
+    filterBank.setHighCut(coefficients.highCut);
+
+    for (int i = 0; i < numParametricBands; ++i)
+    {
+        const auto& bandSettings = chainSettings.bands[static_cast<size_t>(i)];
+        auto& band = coefficients.bands[static_cast<size_t>(i)];
+
+        designBandFilter(band.section, bandSettings, sampleRate);
+        band.bypassed = isBandFlat(bandSettings);
+
+        filterBank.setBand(i, band);
+    }
+}
+
+//==============================================================================
+/**
+    Streams one file through the chain the plugin renders offline with: in
+    double precision, oversampled, with the latency compensated. Reads in
+    large chunks and reports the realtime factor when done.
+*/
+struct RenderJob : juce::ThreadPoolJob
+{
+    RenderJob(const juce::File& input, const juce::File& output, const ChainSettings& settings,
+        int chunkSize, juce::CriticalSection& outputLock, std::atomic<int>& failures) :
+        juce::ThreadPoolJob(input.getFileName()),
+        inputFile(input), outputFile(output), chainSettings(settings),
+        blockSize(chunkSize), printLock(outputLock), numFailures(failures)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        juce::String error;
+        auto numSamplesRendered = render(error);
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        const juce::ScopedLock sl(printLock);
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << inputFile.getFullPathName() << ": " << error << std::endl;
+            ++numFailures;
+        }
+        else
+        {
+            auto audioSeconds = numSamplesRendered / sampleRate;
+
+            std::cout << inputFile.getFileName() << ": "
+                      << juce::String(audioSeconds, 2) << " s of audio in "
+                      << juce::String(seconds, 3) << " s, "
+                      << juce::String(seconds > 0.0 ? audioSeconds / seconds : 0.0, 1) << "x realtime"
+                      << std::endl;
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::int64 render(juce::String& error)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(inputFile));
+
+        if (reader == nullptr)
+        {
+            error = "can't read this file";
+            return 0;
+        }
+
+        sampleRate = reader->sampleRate;
+        auto numChannels = static_cast<int>(reader->numChannels);
+
+        // Written next to the target and only moved over it once complete, so a
+        // failed render never leaves a partial file, nor appends to an old one
+        juce::TemporaryFile temporaryFile(outputFile);
+        std::unique_ptr<juce::OutputStream> stream(temporaryFile.getFile().createOutputStream());
+
+        // Keep the source's depth where WAV has it
+        auto bitsPerSample = static_cast<int>(reader->bitsPerSample);
+
+        if (bitsPerSample != 16 && bitsPerSample != 32)
+            bitsPerSample = 24;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(stream == nullptr ? nullptr
+            : wav.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(numChannels),
+                bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+        {
+            error = "can't write " + outputFile.getFullPathName();
+            return 0;
+        }
+
+        // The writer owns the stream now
+        stream.release();
+
+        juce::dsp::ProcessSpec spec;
+        spec.maximumBlockSize = static_cast<juce::uint32>(blockSize * oversamplingFactor);
+        spec.numChannels = static_cast<juce::uint32>(numChannels);
+        spec.sampleRate = sampleRate;
+
+        juce::dsp::Oversampling<double> oversampler(static_cast<size_t>(numChannels), oversamplingOrder,
+            juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, true, true);
+        oversampler.initProcessing(static_cast<size_t>(blockSize));
+
+        FilterBank<double> filterBank;
+        filterBank.prepare(spec);
+        designFilters(filterBank, chainSettings, sampleRate * oversamplingFactor);
+
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::AudioBuffer<double> processBuffer(numChannels, blockSize);
+
+        // A host compensates the oversampler's delay: render that much silence
+        // past the end, and drop as many samples from the start
+        auto latency = static_cast<juce::int64>(juce::roundToInt(oversampler.getLatencyInSamples()));
+        auto length = reader->lengthInSamples;
+
+        for (juce::int64 position = 0; position < length + latency; position += blockSize)
+        {
+            auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize), length + latency - position));
+
+            // Past the end of the file this reads silence
+            reader->read(&buffer, 0, numSamples, position, true, true);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* src = buffer.getReadPointer(channel);
+                auto* dst = processBuffer.getWritePointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    dst[i] = src[i];
+            }
+
+            juce::dsp::AudioBlock<double> block(processBuffer.getArrayOfWritePointers(), static_cast<size_t>(numChannels),
+                static_cast<size_t>(numSamples));
+
+            filterBank.process(oversampler.processSamplesUp(block));
+            oversampler.processSamplesDown(block);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* src = processBuffer.getReadPointer(channel);
+                auto* dst = buffer.getWritePointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    dst[i] = static_cast<float>(src[i]);
+            }
+
+            auto skip = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples), latency - position));
+
+            if (!writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip))
+            {
+                error = "write failed";
+                return juce::jmax(static_cast<juce::int64>(0), position - latency);
+            }
+        }
+
+        // Flushes and closes the stream
+        writer.reset();
+
+        if (!temporaryFile.overwriteTargetFileWithTemporary())
+        {
+            error = "can't replace " + outputFile.getFullPathName();
+            return 0;
+        }
+
+        return reader->lengthInSamples;
+    }
+
+    juce::File inputFile, outputFile;
+    ChainSettings chainSettings;
+    int blockSize;
+    double sampleRate{ 44100.0 };
+
+    juce::CriticalSection& printLock;
+    std::atomic<int>& numFailures;
+};
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    auto outputDirectory = args.removeValueForOption("--output");
+    auto threadsOption = args.removeValueForOption("--threads");
+    auto blockSizeOption = args.removeValueForOption("--block-size");
+    ChainSettings chainSettings;
+    juce::String error;
+
+    if (!parseChainSettings(args, chainSettings, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if (outputDirectory.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::File outputDir(juce::File::getCurrentWorkingDirectory().getChildFile(outputDirectory));
+
+    if (!outputDir.createDirectory())
+    {
+        std::cerr << "Can't create " << outputDir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    auto numThreads = threadsOption.isEmpty() ? juce::SystemStats::getNumCpus() : juce::jmax(1, threadsOption.getIntValue());
+    auto blockSize = blockSizeOption.isEmpty() ? 65536 : juce::jmax(64, blockSizeOption.getIntValue());
+
+    juce::ThreadPool pool(numThreads);
+    juce::CriticalSection printLock;
+    std::atomic<int> numFailures{ 0 };
+
+    juce::Array<juce::File> inputFiles, outputFiles;
+
+    for (const auto& arg : args.arguments)
+    {
+        if (arg.isOption())
+        {
+            std::cerr << "Unknown option " << arg.text << std::endl;
+            return 1;
+        }
+
+        auto inputFile = arg.resolveAsFile();
+        auto outputFile = outputDir.getChildFile(inputFile.getFileNameWithoutExtension() + ".wav");
+
+        // Parallel jobs writing the same file would clobber each other, so check
+        // them all before starting any. Case doesn't count, as on most file systems.
+        for (int i = 0; i < outputFiles.size(); ++i)
+        {
+            if (outputFiles[i].getFullPathName().equalsIgnoreCase(outputFile.getFullPathName()))
+            {
+                std::cerr << inputFiles[i].getFullPathName() << " and " << inputFile.getFullPathName()
+                          << " would both be written to " << outputFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        inputFiles.add(inputFile);
+        outputFiles.add(outputFile);
+    }
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    auto numFiles = inputFiles.size();
+
+    for (int i = 0; i < numFiles; ++i)
+        pool.addJob(new RenderJob(inputFiles[i], outputFiles[i], chainSettings, blockSize, printLock, numFailures), true);
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(10);
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    std::cout << numFiles << " files in " << juce::String(seconds, 3) << " s on "
+              << numThreads << " threads, " << numFailures.load() << " failed" << std::endl;
+
+    return numFailures.load() == 0 ? 0 : 1;
+}